@@ -0,0 +1,140 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_ARDUINO_H_
+#define TEST_ARDUINO_H_
+
+/* Minimal Arduino core for the host build of the library. Time is simulated:
+ * millis() only advances through delay() or setFakeMillis()/advanceFakeMillis(),
+ * so that tests are deterministic and blocking calls can be measured.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+#define INPUT   0x0
+#define OUTPUT  0x1
+
+#define LOW     0x0
+#define HIGH    0x1
+
+#define CHANGE  2
+#define FALLING 3
+#define RISING  4
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+/******************************************************************************
+   FUNCTION DECLARATION
+ ******************************************************************************/
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int interrupt, void (*isr)(void), int mode);
+
+/* Host build only */
+void setFakeMillis(unsigned long ms);
+void advanceFakeMillis(unsigned long ms);
+void triggerFakeInterrupt(int pin);
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class Print
+{
+  public:
+    virtual ~Print() { }
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t * buf, size_t size) {
+      size_t n = 0;
+      for (; n < size; n++) write(buf[n]);
+      return n;
+    }
+    size_t write(const char * str) {
+      return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+    }
+};
+
+class String
+{
+  public:
+    String(const char * str = "") : _str(str ? str : "") { }
+    const char * c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+    bool operator==(const String & other) const { return _str == other._str; }
+    bool operator==(const char * other) const { return _str == other; }
+
+  private:
+    std::string _str;
+};
+
+class IPAddress
+{
+  public:
+    IPAddress(uint32_t address = 0) : _address(address) { }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | (b << 8) | (c << 16) | (static_cast<uint32_t>(d) << 24)) { }
+    bool fromString(const char * address);
+    bool operator==(const IPAddress & other) const { return _address == other._address; }
+    bool operator!=(const IPAddress & other) const { return _address != other._address; }
+
+  private:
+    uint32_t _address;
+};
+
+#define INADDR_NONE IPAddress(0)
+
+class Client : public Print
+{
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+class UDP : public Print
+{
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+class HardwareSerial : public Print
+{
+  public:
+    virtual size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+#endif /* TEST_ARDUINO_H_ */
@@ -0,0 +1,72 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_ARDUINO_DEBUG_UTILS_H_
+#define TEST_ARDUINO_DEBUG_UTILS_H_
+
+/* Stand-in for Arduino_DebugUtils: messages up to the debug level are
+ * formatted, as the real library does, and written to the output stream (if
+ * any), so that the cost of the log messages is part of the measurements.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdarg.h>
+
+#include <Arduino.h>
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+#define DBG_NONE    -1
+#define DBG_ERROR    0
+#define DBG_WARNING  1
+#define DBG_INFO     2
+#define DBG_DEBUG    3
+#define DBG_VERBOSE  4
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class Arduino_DebugUtils
+{
+  public:
+
+    Arduino_DebugUtils();
+
+    void setDebugLevel(int const debug_level) { _debug_level = debug_level; }
+    int getDebugLevel() const { return _debug_level; }
+    void setDebugOutputStream(Print * stream) { _debug_output_stream = stream; }
+
+    void print(int const debug_level, const char * fmt, ...);
+    void print(int const debug_level, const __FlashStringHelper * fmt, ...);
+
+  private:
+
+    int _debug_level;
+    Print * _debug_output_stream;
+
+    void vPrint(int const debug_level, const char * fmt, va_list args);
+};
+
+extern Arduino_DebugUtils Debug;
+
+#endif /* TEST_ARDUINO_DEBUG_UTILS_H_ */
@@ -0,0 +1,145 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_CELLULAR_NETWORK_H_
+#define TEST_CELLULAR_NETWORK_H_
+
+/* Simulated cellular network, shared by the MKRGSM, MKRNB and (Portenta) GSM
+ * stand-ins. The network registration (which includes the SIM unlock) takes
+ * registration_ms once the network is available, the PDP context activation
+ * (GPRS attach) takes attach_ms. In asynchronous mode ready() polls them, in
+ * synchronous mode begin() blocks until registered or until begin_timeout_ms.
+ * The modems are owned by the connection handlers, hence the simulated
+ * network is the global CellularNetwork.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+struct CellularSimulation
+{
+  /* Behaviour */
+  bool sim_present = true;
+  bool pin_valid = true;
+  bool network_available = false;
+  bool gprs_available = true;
+  unsigned long registration_ms = 0;
+  unsigned long attach_ms = 0;
+  unsigned long begin_timeout_ms = 60000;
+  unsigned long ping_ms = 0;
+  unsigned long time = 0;
+
+  /* Observations */
+  unsigned int begin_calls = 0;
+  unsigned int attach_calls = 0;
+  unsigned int ping_calls = 0;
+  unsigned int shutdown_calls = 0;
+  unsigned int time_reads = 0;
+  bool registered = false;
+  bool attached = false;
+
+  void begin()
+  {
+    begin_calls++;
+    registered = false;
+    attached = false;
+    _registration_start_ms = millis();
+  }
+
+  /* 0 while in progress, 1 once registered, 2 on a SIM error */
+  int registrationReady()
+  {
+    if (!sim_present || !pin_valid)
+      return 2;
+    if (!registered && network_available && (millis() - _registration_start_ms) >= registration_ms)
+      registered = true;
+    return registered ? 1 : 0;
+  }
+
+  /* Blocks until registered, returns whether it was */
+  bool beginSynchronous()
+  {
+    begin();
+    if (!sim_present || !pin_valid)
+      return false;
+    if (!network_available || registration_ms > begin_timeout_ms)
+    {
+      delay(begin_timeout_ms);
+      return false;
+    }
+    delay(registration_ms);
+    registered = true;
+    return true;
+  }
+
+  void attach()
+  {
+    attach_calls++;
+    attached = false;
+    _attach_start_ms = millis();
+  }
+
+  /* 0 while in progress, 1 once attached, 2 if not registered */
+  int attachReady()
+  {
+    if (!registered)
+      return 2;
+    if (!attached && gprs_available && (millis() - _attach_start_ms) >= attach_ms)
+      attached = true;
+    return attached ? 1 : 0;
+  }
+
+  int ping()
+  {
+    ping_calls++;
+    delay(ping_ms);
+    return (attached && network_available) ? static_cast<int>(ping_ms) : -1;
+  }
+
+  int isAccessAlive() const
+  {
+    return (registered && network_available) ? 1 : 0;
+  }
+
+  void shutdown()
+  {
+    shutdown_calls++;
+    registered = false;
+    attached = false;
+  }
+
+  unsigned long getTime()
+  {
+    time_reads++;
+    return registered ? time : 0;
+  }
+
+  /* Internal */
+  unsigned long _registration_start_ms = 0;
+  unsigned long _attach_start_ms = 0;
+};
+
+extern CellularSimulation CellularNetwork;
+
+#endif /* TEST_CELLULAR_NETWORK_H_ */
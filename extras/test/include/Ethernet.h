@@ -0,0 +1,97 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_ETHERNET_H_
+#define TEST_ETHERNET_H_
+
+/* Simulated Ethernet interface: begin() blocks while waiting for the
+ * configuration (at most the given timeout), and succeeds if a cable is
+ * plugged in and, when no static IP is given, a DHCP server answers. Like the
+ * W5100 and some mbed cores, the link status is only known once begin() has
+ * been called, unless link_known_before_begin is set.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum EthernetHardwareStatus { EthernetNoHardware, EthernetW5100, EthernetW5200, EthernetW5500 };
+enum EthernetLinkStatus { Unknown, LinkON, LinkOFF };
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class EthernetClass
+{
+  public:
+
+    /* Host build only */
+    EthernetHardwareStatus hardware = EthernetW5500;
+    bool cable_plugged = false;
+    bool dhcp_available = true;
+    bool link_known_before_begin = false;
+    unsigned long configuration_ms = 0;
+    unsigned int begin_calls = 0;
+
+    EthernetHardwareStatus hardwareStatus() { return hardware; }
+
+    EthernetLinkStatus linkStatus()
+    {
+      if (!_begun && !link_known_before_begin)
+        return LinkOFF;
+      return cable_plugged ? LinkON : LinkOFF;
+    }
+
+    int begin(uint8_t *, unsigned long const timeout = 60000, unsigned long const = 4000)
+    {
+      return configure(dhcp_available, timeout);
+    }
+
+    int begin(uint8_t *, IPAddress, IPAddress, IPAddress, IPAddress, unsigned long const timeout = 60000, unsigned long const = 4000)
+    {
+      return configure(true, timeout);
+    }
+
+    int disconnect() { _begun = false; return 1; }
+
+  private:
+
+    bool _begun = false;
+
+    int configure(bool const server_answers, unsigned long const timeout)
+    {
+      begin_calls++;
+      _begun = true;
+      bool const success = cable_plugged && server_answers && configuration_ms <= timeout;
+      delay(success ? configuration_ms : timeout);
+      return success ? 1 : 0;
+    }
+};
+
+extern EthernetClass Ethernet;
+
+class EthernetClient : public Client { };
+class EthernetUDP : public UDP { };
+
+#endif /* TEST_ETHERNET_H_ */
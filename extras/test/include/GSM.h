@@ -0,0 +1,74 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_GSM_H_
+#define TEST_GSM_H_
+
+/* Stand-in of the GSM library of the Portenta CatM1/NB-IoT shield (and Edge
+ * Control), talking to the simulated CellularNetwork. begin() registers and
+ * activates the data context synchronously.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "CellularNetwork.h"
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum RadioAccessTechnologyType { CATM1 = 7, CATNB = 8 };
+
+#define BAND_3  0x04
+#define BAND_19 0x40000
+#define BAND_20 0x80000
+
+#define ON_MKR2 0x42
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class GSMClass
+{
+  public:
+
+    int begin(const char *, const char *, const char *, const char *, RadioAccessTechnologyType, uint32_t, bool restart = true)
+    {
+      restarts += restart ? 1 : 0;
+      if (!CellularNetwork.beginSynchronous())
+        return 0;
+      CellularNetwork.attach();
+      delay(CellularNetwork.attach_ms);
+      return CellularNetwork.attachReady() == 1;
+    }
+
+    int isConnected() { return CellularNetwork.isAccessAlive(); }
+    int disconnect() { CellularNetwork.shutdown(); return 1; }
+    unsigned long getTime() { return CellularNetwork.getTime(); }
+
+    unsigned int restarts = 0;
+};
+
+extern GSMClass GSM;
+
+class GSMClient : public Client { };
+class GSMUDP : public UDP { };
+
+#endif /* TEST_GSM_H_ */
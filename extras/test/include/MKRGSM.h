@@ -0,0 +1,85 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_MKRGSM_H_
+#define TEST_MKRGSM_H_
+
+/* MKRGSM stand-in, talking to the simulated CellularNetwork */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "CellularNetwork.h"
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum GSM3_NetworkStatus_t { ERROR, IDLE, CONNECTING, GSM_READY, GPRS_READY, TRANSPARENT_CONNECTED, GSM_OFF };
+
+#define GPRS_PING_ERROR -1
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class GSM
+{
+  public:
+
+    GSM3_NetworkStatus_t begin(const char *, bool = true, bool synchronous = true)
+    {
+      if (synchronous)
+        return CellularNetwork.beginSynchronous() ? GSM_READY : ERROR;
+      CellularNetwork.begin();
+      return IDLE;
+    }
+
+    int ready() { return CellularNetwork.registrationReady(); }
+    void setTimeout(unsigned long timeout) { timeout_ms = timeout; }
+    int isAccessAlive() { return CellularNetwork.isAccessAlive(); }
+    bool shutdown() { CellularNetwork.shutdown(); return true; }
+    unsigned long getTime() { return CellularNetwork.getTime(); }
+
+    unsigned long timeout_ms = 0;
+};
+
+class GPRS
+{
+  public:
+
+    GSM3_NetworkStatus_t attachGPRS(const char *, const char *, const char *, bool synchronous = true)
+    {
+      CellularNetwork.attach();
+      if (!synchronous)
+        return IDLE;
+      delay(CellularNetwork.attach_ms);
+      return (CellularNetwork.attachReady() == 1) ? GPRS_READY : ERROR;
+    }
+
+    int ready() { return CellularNetwork.attachReady(); }
+    void setTimeout(unsigned long timeout) { timeout_ms = timeout; }
+    int ping(const char *, uint8_t = 128) { return CellularNetwork.ping(); }
+
+    unsigned long timeout_ms = 0;
+};
+
+class GSMClient : public Client { };
+class GSMUDP : public UDP { };
+
+#endif /* TEST_MKRGSM_H_ */
@@ -0,0 +1,79 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_MKRNB_H_
+#define TEST_MKRNB_H_
+
+/* MKRNB stand-in, talking to the simulated CellularNetwork */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "CellularNetwork.h"
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum NB_NetworkStatus_t { NB_ERROR, IDLE, CONNECTING, NB_READY, GPRS_READY, TRANSPARENT_CONNECTED, NB_OFF };
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class NB
+{
+  public:
+
+    NB_NetworkStatus_t begin(const char *, const char *, const char *, const char *, bool = true, bool synchronous = true)
+    {
+      if (synchronous)
+        return CellularNetwork.beginSynchronous() ? NB_READY : NB_ERROR;
+      CellularNetwork.begin();
+      return IDLE;
+    }
+
+    int ready() { return CellularNetwork.registrationReady(); }
+    void setTimeout(unsigned long timeout) { timeout_ms = timeout; }
+    int isAccessAlive() { return CellularNetwork.isAccessAlive(); }
+    bool shutdown() { CellularNetwork.shutdown(); return true; }
+    unsigned long getTime() { return CellularNetwork.getTime(); }
+
+    unsigned long timeout_ms = 0;
+};
+
+class GPRS
+{
+  public:
+
+    NB_NetworkStatus_t attachGPRS(bool synchronous = true)
+    {
+      CellularNetwork.attach();
+      if (!synchronous)
+        return IDLE;
+      delay(CellularNetwork.attach_ms);
+      return (CellularNetwork.attachReady() == 1) ? GPRS_READY : NB_ERROR;
+    }
+
+    int ready() { return CellularNetwork.attachReady(); }
+};
+
+class NBClient : public Client { };
+class NBUDP : public UDP { };
+
+#endif /* TEST_MKRNB_H_ */
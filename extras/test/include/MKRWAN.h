@@ -0,0 +1,113 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_MKRWAN_H_
+#define TEST_MKRWAN_H_
+
+/* Simulated Murata LoRa modem: begin() blocks for begin_ms, an OTAA join
+ * blocks for join_ms (at most the given timeout) and succeeds if the network
+ * is in range. The modem is owned by the connection handler, hence the
+ * simulated network it talks to is the global LoRaNetwork.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include <vector>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum _lora_band { AS923, AU915, CN470, CN779, EU433, EU868, KR920, IN865, US915 };
+enum _lora_class { CLASS_A = 'A', CLASS_B, CLASS_C };
+
+struct LoRaSimulation
+{
+  bool hardware_present = true;
+  bool network_available = false;
+  unsigned long begin_ms = 0;
+  unsigned long join_ms = 0;
+  unsigned int begin_calls = 0;
+  unsigned int join_calls = 0;
+  std::vector<uint8_t> downlink;
+  size_t downlink_pos = 0;
+};
+
+extern LoRaSimulation LoRaNetwork;
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class LoRaModem
+{
+  public:
+
+    int begin(_lora_band)
+    {
+      LoRaNetwork.begin_calls++;
+      delay(LoRaNetwork.begin_ms);
+      return LoRaNetwork.hardware_present ? 1 : 0;
+    }
+
+    bool sendMask(const char *) { return true; }
+    bool configureClass(_lora_class) { return true; }
+
+    int joinOTAA(const char *, const char *, const char * = NULL, uint32_t const timeout = 60000)
+    {
+      LoRaNetwork.join_calls++;
+      bool const joined = LoRaNetwork.network_available && LoRaNetwork.join_ms <= timeout;
+      delay(joined ? LoRaNetwork.join_ms : timeout);
+      _joined = joined;
+      return joined ? 1 : 0;
+    }
+
+    int connected() { return _joined && LoRaNetwork.network_available; }
+
+    int beginPacket() { return 1; }
+    size_t write(const uint8_t *, size_t size) { return size; }
+    int endPacket(bool) { return 0; }
+
+    int available() { return LoRaNetwork.downlink.size() - LoRaNetwork.downlink_pos; }
+    int peek() { return available() ? LoRaNetwork.downlink[LoRaNetwork.downlink_pos] : -1; }
+    int read() { return available() ? LoRaNetwork.downlink[LoRaNetwork.downlink_pos++] : -1; }
+
+    String version() { return "ARD-078 1.2.3"; }
+    String deviceEUI() { return "0000000000000000"; }
+    int getChannelMaskSize(_lora_band) { return 6; }
+    String getChannelMask() { return "ff000000f000ffff00020000"; }
+    int isChannelEnabled(int) { return 1; }
+    int getDataRate() { return 0; }
+    int getADR() { return 0; }
+    String getDevAddr() { return "00000000"; }
+    String getNwkSKey() { return ""; }
+    String getAppSKey() { return ""; }
+    int getRX2DR() { return 0; }
+    uint32_t getRX2Freq() { return 869525000; }
+    int32_t getFCU() { return 0; }
+    int32_t getFCD() { return 0; }
+
+  private:
+
+    bool _joined = false;
+};
+
+#endif /* TEST_MKRWAN_H_ */
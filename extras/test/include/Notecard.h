@@ -0,0 +1,170 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_NOTECARD_H_
+#define TEST_NOTECARD_H_
+
+/* Simulated Notecard, together with the subset of the note-c JSON API used by
+ * the library. Every transaction advances the fake clock by transaction_ms,
+ * plus the time needed to move the request and the response over the wire
+ * when bytes_per_second is set. The Notecard is owned by the connection
+ * handler, hence the simulated device is the global NotecardDevice.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+#define NOTE_I2C_ADDR_DEFAULT 0x17
+#define NOTE_I2C_MAX_DEFAULT  30
+
+#define TSTRING(n) "x"
+#define TUINT8     14
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+struct J
+{
+  enum Type { OBJECT, ARRAY, STRING, NUMBER, BOOL };
+
+  Type type;
+  std::string name;
+  std::string string;
+  long number;
+  std::vector<J *> children;
+};
+
+struct NotecardSimulation
+{
+  struct OutboundNote
+  {
+    size_t size;
+    bool binary;
+  };
+
+  /* Behaviour */
+  bool transport_connected = false;
+  bool connected_to_notehub = false;
+  unsigned long transaction_ms = 0;
+  unsigned long bytes_per_second = 0;
+  unsigned int bus_errors = 0;        /* The next N transactions get no response */
+  const char * bus_error_request = nullptr; /* Only those of this request */
+  unsigned int allocation_errors = 0; /* The next N requests can't be allocated */
+  unsigned int hub_set_errors = 0;    /* The next N hub.set are rejected */
+  int attn_pin = -1;
+  bool attn_signals_pending = true;   /* card.attn fires right away if a Note is queued */
+  uint32_t time = 0;
+
+  /* Observations */
+  unsigned long transactions = 0;
+  unsigned long wire_bytes = 0;
+  std::map<std::string, unsigned long> requests;
+  std::vector<OutboundNote> outbound;
+  bool attn_armed = false;
+
+  /* Queues a Note in the inbound Notefile, signalling it on ATTN if armed */
+  void queueInbound(uint8_t topic, std::vector<uint8_t> const & payload);
+  /* Queues a Note right after the response to the next `request` transaction */
+  void queueInboundAfter(char const * request, uint8_t topic, std::vector<uint8_t> const & payload);
+  size_t inboundCount() const { return _inbound.size(); }
+  unsigned long requestCount(char const * request) const;
+
+  J * transaction(J * req);
+  char const * storeBinary(uint8_t const * data, uint32_t size, uint32_t offset);
+  void resetBinary() { _binary_size = 0; }
+
+  private:
+
+    struct InboundNote
+    {
+      uint8_t topic;
+      std::vector<uint8_t> payload;
+    };
+
+    struct Arrival
+    {
+      std::string request;
+      InboundNote note;
+    };
+
+    std::deque<InboundNote> _inbound;
+    std::deque<Arrival> _arrivals;
+    size_t _binary_size = 0;
+    unsigned long _wire_us = 0;
+
+    void transfer(size_t bytes);
+    void fireAttn();
+};
+
+extern NotecardSimulation NotecardDevice;
+
+/******************************************************************************
+   FUNCTION DECLARATION
+ ******************************************************************************/
+
+J * NoteNewRequest(const char * request);
+bool NoteResponseError(J * rsp);
+bool NoteErrorContains(const char * err, const char * error_type);
+const char * NoteBinaryStoreReset();
+const char * NoteBinaryStoreTransmit(uint8_t * data, uint32_t data_len, uint32_t buf_len, uint32_t offset);
+
+const char * JGetString(J * json, const char * field);
+long JGetInt(J * json, const char * field);
+bool JGetBool(J * json, const char * field);
+J * JGetObject(J * json, const char * field);
+J * JAddStringToObject(J * json, const char * field, const char * value);
+J * JAddIntToObject(J * json, const char * field, long value);
+J * JAddBoolToObject(J * json, const char * field, bool value);
+J * JAddObjectToObject(J * json, const char * field);
+J * JAddArrayToObject(J * json, const char * field);
+bool JAddBinaryToObject(J * json, const char * field, const void * data, uint32_t len);
+void JAddItemToArray(J * array, J * item);
+J * JCreateString(const char * value);
+void JDelete(J * json);
+void JFree(void * p);
+int JB64DecodeLen(const char * encoded);
+int JB64Decode(char * decoded, const char * encoded);
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class Notecard
+{
+  public:
+    void begin(HardwareSerial &, uint32_t) { }
+    void begin(uint32_t, uint32_t, TwoWire &) { }
+    void setDebugOutputStream(Print &) { }
+    J * newRequest(const char * request) { return NoteNewRequest(request); }
+    J * requestAndResponse(J * req) { return NotecardDevice.transaction(req); }
+};
+
+#endif /* TEST_NOTECARD_H_ */
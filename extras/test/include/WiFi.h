@@ -0,0 +1,97 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_WIFI_H_
+#define TEST_WIFI_H_
+
+/* Simulated WiFi radio: begin() blocks for begin_blocking_ms (as on the
+ * WiFiNINA/mbed cores), then the station is associated association_ms after
+ * begin() as long as the access point is up.
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+enum
+{
+  WL_IDLE_STATUS  = 0,
+  WL_CONNECTED    = 3,
+  WL_DISCONNECTED = 6,
+  WL_NO_SHIELD    = 255
+};
+
+#define WIFI_STA 1
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class WiFiClass
+{
+  public:
+
+    /* Host build only */
+    bool hardware_present = true;
+    bool access_point_up = false;
+    unsigned long begin_blocking_ms = 0;
+    unsigned long association_ms = 0;
+    unsigned int begin_calls = 0;
+
+    int status()
+    {
+      if (!hardware_present)
+        return WL_NO_SHIELD;
+      if (!_associating)
+        return WL_IDLE_STATUS;
+      if (access_point_up && (millis() - _begin_ms) >= association_ms)
+        return WL_CONNECTED;
+      return WL_DISCONNECTED;
+    }
+
+    int begin(const char *, const char *)
+    {
+      begin_calls++;
+      _associating = true;
+      _begin_ms = millis();
+      delay(begin_blocking_ms);
+      return status();
+    }
+
+    const char * firmwareVersion() { return "1.5.0"; }
+    void mode(int) { }
+    void disconnect() { _associating = false; }
+    void end() { _associating = false; }
+    unsigned long getTime() { return 0; }
+
+  private:
+
+    bool _associating = false;
+    unsigned long _begin_ms = 0;
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public Client { };
+
+#endif /* TEST_WIFI_H_ */
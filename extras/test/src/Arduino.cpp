@@ -0,0 +1,143 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <Arduino_DebugUtils.h>
+
+#include <stdio.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static int const INTERRUPT_PIN_COUNT = 64;
+
+/******************************************************************************
+   GLOBAL VARIABLES
+ ******************************************************************************/
+
+static unsigned long fake_millis = 0;
+static void (*interrupt_isr[INTERRUPT_PIN_COUNT])(void) = { nullptr };
+
+Arduino_DebugUtils Debug;
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+unsigned long millis()
+{
+  return fake_millis;
+}
+
+unsigned long micros()
+{
+  return fake_millis * 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+  fake_millis += ms;
+}
+
+void pinMode(int, int)
+{
+}
+
+void digitalWrite(int, int)
+{
+}
+
+int digitalPinToInterrupt(int pin)
+{
+  return pin;
+}
+
+void attachInterrupt(int interrupt, void (*isr)(void), int)
+{
+  if (interrupt >= 0 && interrupt < INTERRUPT_PIN_COUNT)
+    interrupt_isr[interrupt] = isr;
+}
+
+void setFakeMillis(unsigned long ms)
+{
+  fake_millis = ms;
+}
+
+void advanceFakeMillis(unsigned long ms)
+{
+  fake_millis += ms;
+}
+
+void triggerFakeInterrupt(int pin)
+{
+  if (pin >= 0 && pin < INTERRUPT_PIN_COUNT && interrupt_isr[pin])
+    interrupt_isr[pin]();
+}
+
+/******************************************************************************
+   CLASS MEMBER DEFINITION
+ ******************************************************************************/
+
+bool IPAddress::fromString(const char * address)
+{
+  unsigned int a, b, c, d;
+  if (!address || sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+    return false;
+  *this = IPAddress(a, b, c, d);
+  return true;
+}
+
+Arduino_DebugUtils::Arduino_DebugUtils()
+: _debug_level{DBG_INFO}
+, _debug_output_stream{nullptr}
+{
+}
+
+void Arduino_DebugUtils::print(int const debug_level, const char * fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vPrint(debug_level, fmt, args);
+  va_end(args);
+}
+
+void Arduino_DebugUtils::print(int const debug_level, const __FlashStringHelper * fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vPrint(debug_level, reinterpret_cast<const char *>(fmt), args);
+  va_end(args);
+}
+
+void Arduino_DebugUtils::vPrint(int const debug_level, const char * fmt, va_list args)
+{
+  if (debug_level < DBG_ERROR || debug_level > _debug_level)
+    return;
+
+  char msg[128];
+  int const len = vsnprintf(msg, sizeof(msg), fmt, args);
+  if (_debug_output_stream && len > 0)
+  {
+    _debug_output_stream->write(reinterpret_cast<const uint8_t *>(msg), (static_cast<size_t>(len) < sizeof(msg)) ? len : (sizeof(msg) - 1));
+    _debug_output_stream->write('\n');
+  }
+}
@@ -0,0 +1,72 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_CHECK_DURATION_H_
+#define TEST_CHECK_DURATION_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include <chrono>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+struct CheckDuration
+{
+  unsigned long max_blocking_ms; /* Simulated time, see maxCheckDuration() */
+  double max_wall_us;
+  unsigned long calls;
+};
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Calls check() once per simulated millisecond for duration_ms, and returns
+ * the longest time a single call took. The stand-ins of the host build advance
+ * the fake clock while they block (as delay() does), hence max_blocking_ms is
+ * the time the call would have blocked the sketch on the target.
+ */
+template <typename Handler>
+CheckDuration maxCheckDuration(Handler & handler, unsigned long const duration_ms)
+{
+  CheckDuration result = { 0, 0.0, 0 };
+  unsigned long const start = millis();
+
+  while ((millis() - start) < duration_ms)
+  {
+    advanceFakeMillis(1);
+    unsigned long const before = millis();
+    auto const wall_before = std::chrono::steady_clock::now();
+    handler.check();
+    auto const wall_after = std::chrono::steady_clock::now();
+
+    unsigned long const blocking_ms = millis() - before;
+    double const wall_us = std::chrono::duration<double, std::micro>(wall_after - wall_before).count();
+    if (blocking_ms > result.max_blocking_ms) result.max_blocking_ms = blocking_ms;
+    if (wall_us > result.max_wall_us) result.max_wall_us = wall_us;
+    result.calls++;
+  }
+  return result;
+}
+
+#endif /* TEST_CHECK_DURATION_H_ */
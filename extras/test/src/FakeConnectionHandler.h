@@ -0,0 +1,165 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_FAKE_CONNECTION_HANDLER_H_
+#define TEST_FAKE_CONNECTION_HANDLER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino_ConnectionHandler.h>
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Adapter whose network is simulated: connecting succeeds as soon as the link
+ * is up, and the connection is lost as soon as the link goes down. While the
+ * link is down, every connection attempt fails after attempt_duration_ms (0:
+ * within the check() that started it) and is reported to the reconnect
+ * backoff. With hardware_error set the initialization fails. The calls of each
+ * update_handle*() function and the connection attempts are counted. getTime()
+ * reads, through the time cache, a time source which started at time_epoch
+ * (at millis() 0) and runs time_drift_ppm faster than millis().
+ */
+class FakeConnectionHandler : public ConnectionHandler
+{
+  public:
+
+    FakeConnectionHandler(bool const keep_alive = true, NetworkAdapter const interface = NetworkAdapter::WIFI)
+    : ConnectionHandler{keep_alive, interface}
+    , link_up{false}
+    , hardware_error{false}
+    , attempt_duration_ms{0}
+    , attempts{0}
+    , time_epoch{0}
+    , time_drift_ppm{0}
+    , time_reads{0}
+    , handled{}
+    , _attempt_pending{false}
+    , _attempt_start{0}
+    { }
+
+    bool link_up;
+    bool hardware_error;
+    unsigned long attempt_duration_ms;
+    unsigned int attempts;
+    unsigned long time_epoch;
+    long time_drift_ppm;
+    unsigned int time_reads;
+    unsigned int handled[NETWORK_CONNECTION_STATE_COUNT];
+
+    virtual unsigned long getTime()
+    {
+      unsigned long time = getCachedTime();
+      if (!time)
+      {
+        time = sourceTime();
+        time_reads++;
+        updateTimeCache(time);
+      }
+      return time;
+    }
+
+    /* Time of the source, i.e. the reference getTime() is checked against */
+    unsigned long sourceTime() const
+    {
+      if (!time_epoch)
+        return 0;
+      return time_epoch + (millis() * (1000000LL + time_drift_ppm)) / 1000000000LL;
+    }
+    virtual Client & getClient() { return _client; }
+    virtual UDP & getUDP() { return _udp; }
+
+    using ConnectionHandler::currentState;
+
+
+  protected:
+
+    virtual NetworkConnectionState update_handleInit() override
+    {
+      count(NetworkConnectionState::INIT);
+      if (hardware_error)
+      {
+        setTransitionReason(TransitionReason::HARDWARE_ERROR);
+        return NetworkConnectionState::ERROR;
+      }
+      _attempt_pending = false;
+      return NetworkConnectionState::CONNECTING;
+    }
+
+    virtual NetworkConnectionState update_handleConnecting() override
+    {
+      count(NetworkConnectionState::CONNECTING);
+      if (link_up)
+      {
+        _attempt_pending = false;
+        return NetworkConnectionState::CONNECTED;
+      }
+
+      if (!_attempt_pending)
+      {
+        attempts++;
+        _attempt_pending = true;
+        _attempt_start = millis();
+      }
+      if ((millis() - _attempt_start) >= attempt_duration_ms)
+      {
+        _attempt_pending = false;
+        connectionAttemptFailed();
+      }
+      return NetworkConnectionState::CONNECTING;
+    }
+
+    virtual NetworkConnectionState update_handleConnected() override
+    {
+      count(NetworkConnectionState::CONNECTED);
+      if (!link_up)
+      {
+        setTransitionReason(TransitionReason::CONNECTION_LOST);
+        return NetworkConnectionState::DISCONNECTED;
+      }
+      return NetworkConnectionState::CONNECTED;
+    }
+
+    virtual NetworkConnectionState update_handleDisconnecting() override
+    {
+      count(NetworkConnectionState::DISCONNECTING);
+      return NetworkConnectionState::DISCONNECTED;
+    }
+
+    virtual NetworkConnectionState update_handleDisconnected() override
+    {
+      count(NetworkConnectionState::DISCONNECTED);
+      return _keep_alive ? NetworkConnectionState::INIT : NetworkConnectionState::CLOSED;
+    }
+
+
+  private:
+
+    Client _client;
+    UDP _udp;
+    bool _attempt_pending;
+    unsigned long _attempt_start;
+
+    void count(NetworkConnectionState const state) {
+      handled[static_cast<unsigned int>(state)]++;
+    }
+};
+
+#endif /* TEST_FAKE_CONNECTION_HANDLER_H_ */
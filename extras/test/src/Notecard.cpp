@@ -0,0 +1,437 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Notecard.h>
+
+#include <stdio.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static char const BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Size of the card.binary.put request preceding every binary chunk */
+static size_t const BINARY_PUT_OVERHEAD = 48;
+
+/******************************************************************************
+   GLOBAL VARIABLES
+ ******************************************************************************/
+
+NotecardSimulation NotecardDevice;
+TwoWire Wire;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static J * createJ(J::Type const type, const char * name)
+{
+  J * json = new J;
+  json->type = type;
+  json->name = name ? name : "";
+  json->number = 0;
+  return json;
+}
+
+static J * findChild(J * json, const char * field)
+{
+  if (!json)
+    return nullptr;
+  for (J * child : json->children)
+    if (child->name == field)
+      return child;
+  return nullptr;
+}
+
+static J * addChild(J * json, J * child)
+{
+  if (!json)
+  {
+    JDelete(child);
+    return nullptr;
+  }
+  json->children.push_back(child);
+  return child;
+}
+
+static void serialize(J * json, std::string & out)
+{
+  if (!json->name.empty())
+    out += "\"" + json->name + "\":";
+
+  switch (json->type)
+  {
+    case J::OBJECT:
+    case J::ARRAY:
+      out += (json->type == J::OBJECT) ? '{' : '[';
+      for (size_t i = 0; i < json->children.size(); i++)
+      {
+        if (i) out += ',';
+        serialize(json->children[i], out);
+      }
+      out += (json->type == J::OBJECT) ? '}' : ']';
+      break;
+    case J::STRING: out += "\"" + json->string + "\""; break;
+    case J::NUMBER: out += std::to_string(json->number); break;
+    case J::BOOL:   out += json->number ? "true" : "false"; break;
+  }
+}
+
+static size_t serializedSize(J * json)
+{
+  std::string out;
+  serialize(json, out);
+  return out.size() + 1; /* Newline terminated */
+}
+
+static std::string base64Encode(uint8_t const * data, size_t const len)
+{
+  std::string out;
+  out.reserve(((len + 2) / 3) * 4);
+  for (size_t i = 0; i < len; i += 3)
+  {
+    uint32_t const n = (data[i] << 16) | ((i + 1 < len) ? (data[i + 1] << 8) : 0) | ((i + 2 < len) ? data[i + 2] : 0);
+    out += BASE64_ALPHABET[(n >> 18) & 0x3F];
+    out += BASE64_ALPHABET[(n >> 12) & 0x3F];
+    out += (i + 1 < len) ? BASE64_ALPHABET[(n >> 6) & 0x3F] : '=';
+    out += (i + 2 < len) ? BASE64_ALPHABET[n & 0x3F] : '=';
+  }
+  return out;
+}
+
+static size_t base64DecodedSize(const char * encoded)
+{
+  size_t const len = strlen(encoded);
+  size_t const padding = (len && encoded[len - 1] == '=') + (len > 1 && encoded[len - 2] == '=');
+  return (len / 4) * 3 - padding;
+}
+
+static J * errorResponse(const char * err)
+{
+  J * rsp = createJ(J::OBJECT, nullptr);
+  JAddStringToObject(rsp, "err", err);
+  return rsp;
+}
+
+/******************************************************************************
+   CLASS MEMBER DEFINITION
+ ******************************************************************************/
+
+void NotecardSimulation::queueInbound(uint8_t topic, std::vector<uint8_t> const & payload)
+{
+  _inbound.push_back(InboundNote{topic, payload});
+  if (attn_armed)
+    fireAttn();
+}
+
+void NotecardSimulation::queueInboundAfter(char const * request, uint8_t topic, std::vector<uint8_t> const & payload)
+{
+  _arrivals.push_back(Arrival{request, InboundNote{topic, payload}});
+}
+
+unsigned long NotecardSimulation::requestCount(char const * request) const
+{
+  auto const it = requests.find(request);
+  return (it == requests.end()) ? 0 : it->second;
+}
+
+J * NotecardSimulation::transaction(J * req)
+{
+  if (!req)
+    return nullptr;
+
+  std::string const name = JGetString(req, "req");
+  transactions++;
+  requests[name]++;
+  delay(transaction_ms);
+  transfer(serializedSize(req));
+
+  J * rsp = nullptr;
+  if (bus_errors && (!bus_error_request || name == bus_error_request))
+  {
+    bus_errors--;
+  }
+  else if (name == "note.get")
+  {
+    if (_inbound.empty())
+    {
+      rsp = errorResponse("no note available {note-noexist}");
+    }
+    else
+    {
+      InboundNote const & note = _inbound.front();
+      rsp = createJ(J::OBJECT, nullptr);
+      JAddIntToObject(JAddObjectToObject(rsp, "body"), "topic", note.topic);
+      JAddBinaryToObject(rsp, "payload", note.payload.data(), note.payload.size());
+      if (JGetBool(req, "delete"))
+        _inbound.pop_front();
+    }
+  }
+  else if (name == "card.attn")
+  {
+    rsp = createJ(J::OBJECT, nullptr);
+    attn_armed = true;
+    /* The files watched are not empty: signalled right away */
+    if (attn_signals_pending && !_inbound.empty())
+      fireAttn();
+  }
+  else if (name == "hub.set" && hub_set_errors)
+  {
+    hub_set_errors--;
+    rsp = errorResponse("hub.set rejected {io}");
+  }
+  else if (name == "hub.status")
+  {
+    rsp = createJ(J::OBJECT, nullptr);
+    JAddStringToObject(rsp, "status", transport_connected ? "connected (session open) {connected}" : "idle {disconnected}");
+    JAddBoolToObject(rsp, "connected", connected_to_notehub);
+  }
+  else if (name == "hub.get")
+  {
+    rsp = createJ(J::OBJECT, nullptr);
+    JAddStringToObject(rsp, "device", "dev:000000000000000");
+    JAddStringToObject(rsp, "sn", "00000000-0000-0000-0000-000000000000");
+  }
+  else if (name == "card.time")
+  {
+    rsp = createJ(J::OBJECT, nullptr);
+    JAddIntToObject(rsp, "time", time);
+  }
+  else if (name == "note.add")
+  {
+    bool const binary = JGetBool(req, "binary");
+    const char * payload = JGetString(req, "payload");
+    outbound.push_back(OutboundNote{binary ? _binary_size : base64DecodedSize(payload), binary});
+    rsp = createJ(J::OBJECT, nullptr);
+    JAddIntToObject(rsp, "total", outbound.size());
+  }
+  else if (name == "hub.set" || name == "hub.sync" || name == "note.template" || name == "env.template")
+  {
+    rsp = createJ(J::OBJECT, nullptr);
+  }
+  else
+  {
+    rsp = errorResponse("unknown request {io}");
+  }
+
+  JDelete(req);
+  if (rsp)
+    transfer(serializedSize(rsp));
+  if (!_arrivals.empty() && _arrivals.front().request == name)
+  {
+    Arrival const arrival = _arrivals.front();
+    _arrivals.pop_front();
+    queueInbound(arrival.note.topic, arrival.note.payload);
+  }
+  return rsp;
+}
+
+char const * NotecardSimulation::storeBinary(uint8_t const *, uint32_t const size, uint32_t const offset)
+{
+  if (offset != _binary_size)
+    return "binary offset mismatch {io}";
+
+  /* A card.binary.put transaction, followed by the COBS encoded data */
+  transactions++;
+  requests["card.binary.put"]++;
+  delay(transaction_ms);
+  transfer(BINARY_PUT_OVERHEAD + size + (size / 254) + 2);
+  _binary_size += size;
+  return nullptr;
+}
+
+void NotecardSimulation::transfer(size_t const bytes)
+{
+  wire_bytes += bytes;
+  if (!bytes_per_second)
+    return;
+
+  _wire_us += (bytes * 1000000UL) / bytes_per_second;
+  delay(_wire_us / 1000);
+  _wire_us %= 1000;
+}
+
+void NotecardSimulation::fireAttn()
+{
+  attn_armed = false;
+  if (attn_pin >= 0)
+    triggerFakeInterrupt(attn_pin);
+}
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+J * NoteNewRequest(const char * request)
+{
+  if (NotecardDevice.allocation_errors)
+  {
+    NotecardDevice.allocation_errors--;
+    return nullptr;
+  }
+  J * req = createJ(J::OBJECT, nullptr);
+  JAddStringToObject(req, "req", request);
+  return req;
+}
+
+bool NoteResponseError(J * rsp)
+{
+  return !rsp || findChild(rsp, "err");
+}
+
+bool NoteErrorContains(const char * err, const char * error_type)
+{
+  return err && strstr(err, error_type);
+}
+
+const char * NoteBinaryStoreReset()
+{
+  NotecardDevice.resetBinary();
+  return nullptr;
+}
+
+const char * NoteBinaryStoreTransmit(uint8_t * data, uint32_t data_len, uint32_t, uint32_t offset)
+{
+  return NotecardDevice.storeBinary(data, data_len, offset);
+}
+
+const char * JGetString(J * json, const char * field)
+{
+  J * child = findChild(json, field);
+  return (child && child->type == J::STRING) ? child->string.c_str() : "";
+}
+
+long JGetInt(J * json, const char * field)
+{
+  J * child = findChild(json, field);
+  return (child && child->type == J::NUMBER) ? child->number : 0;
+}
+
+bool JGetBool(J * json, const char * field)
+{
+  J * child = findChild(json, field);
+  return (child && child->type == J::BOOL) ? child->number : false;
+}
+
+J * JGetObject(J * json, const char * field)
+{
+  J * child = findChild(json, field);
+  return (child && child->type == J::OBJECT) ? child : nullptr;
+}
+
+J * JAddStringToObject(J * json, const char * field, const char * value)
+{
+  J * child = createJ(J::STRING, field);
+  child->string = value ? value : "";
+  return addChild(json, child);
+}
+
+J * JAddIntToObject(J * json, const char * field, long value)
+{
+  J * child = createJ(J::NUMBER, field);
+  child->number = value;
+  return addChild(json, child);
+}
+
+J * JAddBoolToObject(J * json, const char * field, bool value)
+{
+  J * child = createJ(J::BOOL, field);
+  child->number = value;
+  return addChild(json, child);
+}
+
+J * JAddObjectToObject(J * json, const char * field)
+{
+  return addChild(json, createJ(J::OBJECT, field));
+}
+
+J * JAddArrayToObject(J * json, const char * field)
+{
+  return addChild(json, createJ(J::ARRAY, field));
+}
+
+bool JAddBinaryToObject(J * json, const char * field, const void * data, uint32_t len)
+{
+  J * child = createJ(J::STRING, field);
+  child->string = base64Encode(static_cast<uint8_t const *>(data), len);
+  return addChild(json, child) != nullptr;
+}
+
+void JAddItemToArray(J * array, J * item)
+{
+  if (item)
+  {
+    item->name.clear();
+    addChild(array, item);
+  }
+}
+
+J * JCreateString(const char * value)
+{
+  J * json = createJ(J::STRING, nullptr);
+  json->string = value ? value : "";
+  return json;
+}
+
+void JDelete(J * json)
+{
+  if (!json)
+    return;
+  for (J * child : json->children)
+    JDelete(child);
+  delete json;
+}
+
+void JFree(void * p)
+{
+  /* Only used by the library on allocation failures of the JSON tree, which
+   * the stand-in never reports (see allocation_errors).
+   */
+  free(p);
+}
+
+int JB64DecodeLen(const char * encoded)
+{
+  return ((strlen(encoded) + 3) / 4) * 3 + 1;
+}
+
+int JB64Decode(char * decoded, const char * encoded)
+{
+  int len = 0;
+  uint32_t n = 0;
+  int bits = 0;
+  for (const char * c = encoded; *c && *c != '='; c++)
+  {
+    const char * pos = strchr(BASE64_ALPHABET, *c);
+    if (!pos)
+      continue;
+    n = (n << 6) | (pos - BASE64_ALPHABET);
+    bits += 6;
+    if (bits >= 8)
+    {
+      bits -= 8;
+      decoded[len++] = (n >> bits) & 0xFF;
+    }
+  }
+  decoded[len] = '\0';
+  return len;
+}
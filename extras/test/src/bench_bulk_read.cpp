@@ -0,0 +1,165 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+#include <chrono>
+#include <vector>
+
+
+/* Built for the Notecard (USE_NOTECARD) and for LoRa (ARDUINO_SAMD_MKRWAN1310),
+ * the payload is always read through a ConnectionHandler reference.
+ */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static size_t const PAYLOAD_SIZE = 256;
+static unsigned int const PAYLOADS = 20000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+#if defined(USE_NOTECARD)
+static char const ADAPTER[] = "Notecard";
+
+static NotecardConnectionHandler handler("com.example:project");
+
+static void setUp()
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+  maxCheckDuration(handler, 5000);
+}
+
+/* Buffers the next payload in the handler. Once a payload has been read, the
+ * first call to available() returns false to end the read loop of the sketch.
+ */
+static bool reload(std::vector<uint8_t> const & payload)
+{
+  NotecardDevice.queueInbound(3, payload);
+  return handler.available() || handler.available();
+}
+#else
+static char const ADAPTER[] = "LoRa";
+
+static LoRaConnectionHandler handler("0000000000000000", "00000000000000000000000000000000");
+
+static void setUp()
+{
+  LoRaNetwork = LoRaSimulation();
+  LoRaNetwork.network_available = true;
+  maxCheckDuration(handler, 5000);
+}
+
+static bool reload(std::vector<uint8_t> const & payload)
+{
+  LoRaNetwork.downlink = payload;
+  LoRaNetwork.downlink_pos = 0;
+  return handler.available();
+}
+#endif
+
+/* Bytes per second read through the given path, only the reads are timed */
+template <typename Read>
+static double throughput(ConnectionHandler & conn, Read read_payload, unsigned long & checksum)
+{
+  std::vector<uint8_t> payload(PAYLOAD_SIZE);
+  for (size_t i = 0; i < PAYLOAD_SIZE; i++) payload[i] = i;
+
+  std::chrono::duration<double> elapsed(0);
+  unsigned long bytes = 0;
+  for (unsigned int n = 0; n < PAYLOADS; n++)
+  {
+    if (!reload(payload))
+      return 0.0;
+    auto const start = std::chrono::steady_clock::now();
+    bytes += read_payload(conn, checksum);
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+  return bytes / elapsed.count();
+}
+
+static size_t readPerByte(ConnectionHandler & conn, unsigned long & checksum)
+{
+  size_t count = 0;
+  for (int c; (c = conn.read()) >= 0; count++)
+    checksum += c;
+  return count;
+}
+
+static size_t readBulk(ConnectionHandler & conn, unsigned long & checksum)
+{
+  uint8_t buf[PAYLOAD_SIZE];
+  size_t const count = conn.read(buf, sizeof(buf));
+  for (size_t i = 0; i < count; i++)
+    checksum += buf[i];
+  return count;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(bulk_read_throughput)
+{
+  setFakeMillis(1000);
+  setUp();
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  /* The same payload is read through both paths */
+  unsigned long checksum_per_byte = 0, checksum_bulk = 0;
+  double const per_byte = throughput(handler, readPerByte, checksum_per_byte);
+  double const bulk = throughput(handler, readBulk, checksum_bulk);
+  REQUIRE(per_byte > 0.0);
+  REQUIRE(bulk > 0.0);
+  REQUIRE_EQUAL(checksum_bulk, checksum_per_byte);
+  REQUIRE_EQUAL(checksum_bulk, PAYLOADS * ((PAYLOAD_SIZE - 1) * PAYLOAD_SIZE / 2));
+
+  printf("%s, %zu byte payloads: read() %8.1f MB/s, read(buf, len) %8.1f MB/s (x%.1f)\n",
+         ADAPTER, PAYLOAD_SIZE, per_byte / 1e6, bulk / 1e6, bulk / per_byte);
+}
+
+TEST_CASE(peek_and_payload_size)
+{
+  std::vector<uint8_t> const payload = { 7, 8, 9 };
+  REQUIRE(reload(payload));
+  ConnectionHandler & conn = handler;
+  REQUIRE_EQUAL(conn.payloadSize(), 3);
+  REQUIRE_EQUAL(conn.peek(), 7);
+  REQUIRE_EQUAL(conn.read(), 7);
+  REQUIRE_EQUAL(conn.payloadSize(), 2);
+
+  uint8_t buf[8];
+  REQUIRE_EQUAL(conn.read(buf, sizeof(buf)), 2);
+  REQUIRE_EQUAL(buf[0], 8);
+  REQUIRE_EQUAL(buf[1], 9);
+  REQUIRE_EQUAL(conn.payloadSize(), 0);
+  REQUIRE_EQUAL(conn.read(buf, sizeof(buf)), 0);
+}
+
+TEST_MAIN()
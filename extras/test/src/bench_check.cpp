@@ -0,0 +1,109 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const ITERATIONS = 1000000;
+
+/******************************************************************************
+   GLOBAL VARIABLES
+ ******************************************************************************/
+
+static unsigned long connect_events = 0;
+static unsigned long disconnect_events = 0;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void onConnect()    { connect_events++; }
+static void onDisconnect() { disconnect_events++; }
+
+/* Every state is due on every millisecond */
+static void setZeroCheckIntervals(ConnectionHandler & handler)
+{
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    handler.setCheckInterval(static_cast<NetworkConnectionState>(s), 0);
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(check_idle)
+{
+  setFakeMillis(0);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  while (handler.check() != NetworkConnectionState::CONNECTED)
+    advanceFakeMillis(1);
+
+  /* The CONNECTED interval has not elapsed: check() returns immediately */
+  double const ns = benchmarkNanoseconds(ITERATIONS, [&]() { handler.check(); });
+  printf("check() idle:                %8.1f ns/call\n", ns);
+
+  REQUIRE_EQUAL(handler.handled[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)], 0);
+}
+
+TEST_CASE(check_transitions)
+{
+  setFakeMillis(0);
+  FakeConnectionHandler handler;
+  setZeroCheckIntervals(handler);
+
+  /* Toggling the link on every call makes (almost) every call a transition */
+  double const ns = benchmarkNanoseconds(ITERATIONS, [&]() {
+    advanceFakeMillis(1);
+    handler.link_up = !handler.link_up;
+    handler.check();
+  });
+  printf("check() transition:          %8.1f ns/call\n", ns);
+
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  REQUIRE(metrics.entries[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)] > (ITERATIONS / 8));
+}
+
+TEST_CASE(check_callbacks)
+{
+  setFakeMillis(0);
+  FakeConnectionHandler handler;
+  setZeroCheckIntervals(handler);
+  handler.addCallback(NetworkConnectionEvent::CONNECTED, onConnect);
+  handler.addCallback(NetworkConnectionEvent::DISCONNECTED, onDisconnect);
+
+  double const ns = benchmarkNanoseconds(ITERATIONS, [&]() {
+    advanceFakeMillis(1);
+    handler.link_up = !handler.link_up;
+    handler.check();
+  });
+  printf("check() transition+callback: %8.1f ns/call\n", ns);
+
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  REQUIRE_EQUAL(connect_events, metrics.entries[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)]);
+  REQUIRE_EQUAL(disconnect_events, metrics.entries[static_cast<unsigned int>(NetworkConnectionState::DISCONNECTED)]);
+}
+
+TEST_MAIN()
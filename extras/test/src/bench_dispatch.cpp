@@ -0,0 +1,107 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const ITERATIONS = 1000000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Every state is due on every millisecond */
+static void setZeroCheckIntervals(ConnectionHandler & handler)
+{
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    handler.setCheckInterval(static_cast<NetworkConnectionState>(s), 0);
+}
+
+/* The handler is only known as a ConnectionHandler &, as it would be when
+ * passed to a library: check() is dispatched through the vtable.
+ */
+__attribute__((noinline)) static ConnectionHandler & opaque(ConnectionHandler & handler)
+{
+  __asm__ volatile("" : : "r"(&handler) : "memory");
+  return handler;
+}
+
+/* Toggling the link on every call makes (almost) every call a transition */
+template <class Handler>
+static double checkTransitions(Handler & handler, FakeConnectionHandler & adapter)
+{
+  setFakeMillis(0);
+  setZeroCheckIntervals(adapter);
+  return benchmarkNanoseconds(ITERATIONS, [&]() {
+    advanceFakeMillis(1);
+    adapter.link_up = !adapter.link_up;
+    handler.check();
+  });
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(static_vs_virtual_dispatch)
+{
+  FakeConnectionHandler dynamic_handler;
+  BasicConnectionHandler<FakeConnectionHandler> static_handler;
+  ConnectionHandler & virtual_path = opaque(dynamic_handler);
+
+  double const virtual_ns = checkTransitions(virtual_path, dynamic_handler);
+  double const static_ns = checkTransitions(static_handler, static_handler);
+  printf("check() transition: virtual %6.1f ns/call, BasicConnectionHandler %6.1f ns/call (%+.1f%%)\n",
+         virtual_ns, static_ns, 100.0 * (static_ns - virtual_ns) / virtual_ns);
+  printf("sizeof: FakeConnectionHandler %zu, BasicConnectionHandler<FakeConnectionHandler> %zu bytes\n",
+         sizeof(FakeConnectionHandler), sizeof(BasicConnectionHandler<FakeConnectionHandler>));
+
+  /* Both paths run the same state machine */
+  ConnectionMetrics const & a = dynamic_handler.getMetrics();
+  ConnectionMetrics const & b = static_handler.getMetrics();
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+  {
+    REQUIRE_EQUAL(a.entries[s], b.entries[s]);
+    REQUIRE_EQUAL(a.dwell_ms[s], b.dwell_ms[s]);
+    REQUIRE_EQUAL(dynamic_handler.handled[s], static_handler.handled[s]);
+  }
+  REQUIRE(sizeof(BasicConnectionHandler<FakeConnectionHandler>) == sizeof(FakeConnectionHandler));
+}
+
+TEST_CASE(virtual_call_on_basic_handler)
+{
+  /* Through a ConnectionHandler &, the basic handler takes the virtual path */
+  setFakeMillis(0);
+  BasicConnectionHandler<FakeConnectionHandler> handler;
+  handler.link_up = true;
+  ConnectionHandler & conn = opaque(handler);
+  for (int t = 0; t < 10000 && conn.check() != NetworkConnectionState::CONNECTED; t++)
+    advanceFakeMillis(1);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(handler.getMetrics().entries[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)], 1);
+}
+
+TEST_MAIN()
@@ -0,0 +1,121 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "test.h"
+
+#include <Arduino_ConnectionHandlerLog.h>
+#include <Arduino_DebugUtils.h>
+
+/* Built with the Debug.print() backend (bench_log), and with the tokenized
+ * one (bench_log_tokenized). Both write to a Print counting the bytes, with
+ * messages taken from the library sources.
+ */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const ITERATIONS = 1000000;
+
+static char const NOTECARD_UID[] = "dev:000000000000000";
+static char const DEVICE_ID[] = "00000000-0000-0000-0000-000000000000";
+
+#if defined(CONNECTION_HANDLER_LOG_TOKENIZED)
+static char const BACKEND[] = "tokenized";
+/* Header, then 4 bytes per integer and 1 + length per string */
+static unsigned long const NO_ARGUMENTS_BYTES = 7;
+static unsigned long const INTEGER_ARGUMENTS_BYTES = 7 + 4 + 4;
+static unsigned long const STRING_ARGUMENTS_BYTES = 7 + 1 + 19 + 1 + 36;
+#else
+static char const BACKEND[] = "Debug.print";
+/* The formatted message and a new line */
+static unsigned long const NO_ARGUMENTS_BYTES = 24;
+static unsigned long const INTEGER_ARGUMENTS_BYTES = 27;
+static unsigned long const STRING_ARGUMENTS_BYTES = 105;
+#endif
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+class CountingPrint : public Print
+{
+  public:
+    unsigned long bytes = 0;
+    virtual size_t write(uint8_t) override { bytes++; return 1; }
+    virtual size_t write(const uint8_t *, size_t size) override { bytes += size; return size; }
+    using Print::write;
+};
+
+static CountingPrint log_output;
+
+static void setLogOutput()
+{
+#if defined(CONNECTION_HANDLER_LOG_TOKENIZED)
+  ConnectionHandlerLog::setOutput(log_output);
+#else
+  Debug.setDebugLevel(DBG_VERBOSE);
+  Debug.setDebugOutputStream(&log_output);
+#endif
+}
+
+/* Logs the event ITERATIONS times, and returns the number of bytes per event */
+template <typename Event>
+static unsigned long measure(char const * name, Event event)
+{
+  setLogOutput();
+  log_output.bytes = 0;
+  double const ns = benchmarkNanoseconds(ITERATIONS, event);
+  printf("%-11s %-17s %8.1f ns/event, %4lu bytes/event\n", BACKEND, name, ns, log_output.bytes / ITERATIONS);
+  return (log_output.bytes % ITERATIONS) ? 0 : (log_output.bytes / ITERATIONS);
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(no_arguments)
+{
+  unsigned long const bytes = measure("no arguments", []() {
+    CH_LOG_INFO("Message sent correctly!");
+  });
+  REQUIRE_EQUAL(bytes, NO_ARGUMENTS_BYTES);
+}
+
+TEST_CASE(integer_arguments)
+{
+  int notes = 3, size = 120;
+  unsigned long const bytes = measure("integer arguments", [&]() {
+    CH_LOG_DEBUG("Synced %d Notes (%d bytes)", notes, size);
+  });
+  REQUIRE_EQUAL(bytes, INTEGER_ARGUMENTS_BYTES);
+}
+
+TEST_CASE(string_arguments)
+{
+  unsigned long const bytes = measure("string arguments", []() {
+    CH_LOG_DEBUG("Cached Notecard UID: <%s> and Arduino Device ID: <%s>", NOTECARD_UID, DEVICE_ID);
+  });
+  REQUIRE_EQUAL(bytes, STRING_ARGUMENTS_BYTES);
+}
+
+TEST_MAIN()
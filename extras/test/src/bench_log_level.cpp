@@ -0,0 +1,128 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+
+#include <Arduino_ConnectionHandler.h>
+#include <Arduino_ConnectionHandlerLog.h>
+#include <Arduino_DebugUtils.h>
+
+/* Built once per CONNECTION_HANDLER_LOG_LEVEL, see log_level_report in
+ * CMakeLists.txt. The Notecard handler is the one logging the most. Every
+ * message compiled in is formatted (the Debug level is DBG_VERBOSE) and
+ * counted, so that the cost of the levels stripped at compile time shows.
+ */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const ITERATIONS = 100000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+class CountingPrint : public Print
+{
+  public:
+    unsigned long bytes = 0;
+    virtual size_t write(uint8_t) override { bytes++; return 1; }
+    using Print::write;
+};
+
+static CountingPrint log_output;
+
+static void resetNotecard()
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+}
+
+/* Every state is due on every millisecond */
+static void setZeroCheckIntervals(ConnectionHandler & handler)
+{
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    handler.setCheckInterval(static_cast<NetworkConnectionState>(s), 0);
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(check_reconnecting)
+{
+  Debug.setDebugLevel(DBG_VERBOSE);
+  Debug.setDebugOutputStream(&log_output);
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  setZeroCheckIntervals(handler);
+
+  /* Notehub drops the connection every 20 ms, i.e. a reconnection (and its
+   * messages) every few check() calls
+   */
+  log_output.bytes = 0;
+  unsigned long calls = 0;
+  double const ns = benchmarkNanoseconds(ITERATIONS, [&]() {
+    advanceFakeMillis(1);
+    NotecardDevice.connected_to_notehub = ((++calls % 20) != 0);
+    handler.check();
+  });
+  printf("log level %2d: check() reconnecting %8.1f ns/call, %6.1f log bytes/call\n",
+         CONNECTION_HANDLER_LOG_LEVEL, ns, static_cast<double>(log_output.bytes) / ITERATIONS);
+
+  REQUIRE(handler.getMetrics().entries[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)] > (ITERATIONS / 40));
+#if CONNECTION_HANDLER_LOG_LEVEL < CONNECTION_HANDLER_LOG_LEVEL_ERROR
+  REQUIRE_EQUAL(log_output.bytes, 0);
+#else
+  REQUIRE(log_output.bytes > 0);
+#endif
+}
+
+TEST_CASE(write)
+{
+  Debug.setDebugLevel(DBG_VERBOSE);
+  Debug.setDebugOutputStream(&log_output);
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  while (handler.check() != NetworkConnectionState::CONNECTED)
+    advanceFakeMillis(1);
+
+  /* "Message sent correctly!" is an INFO message */
+  uint8_t const data[] = { 1, 2, 3 };
+  log_output.bytes = 0;
+  double const ns = benchmarkNanoseconds(ITERATIONS, [&]() {
+    handler.write(data, sizeof(data));
+  });
+  printf("log level %2d: write()              %8.1f ns/call, %6.1f log bytes/call\n",
+         CONNECTION_HANDLER_LOG_LEVEL, ns, static_cast<double>(log_output.bytes) / ITERATIONS);
+
+#if CONNECTION_HANDLER_LOG_LEVEL < CONNECTION_HANDLER_LOG_LEVEL_INFO
+  REQUIRE_EQUAL(log_output.bytes, 0);
+#else
+  REQUIRE(log_output.bytes > 0);
+#endif
+}
+
+TEST_MAIN()
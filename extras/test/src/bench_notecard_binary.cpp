@@ -0,0 +1,123 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+#include <vector>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* Notecard on a 400 kHz I2C bus */
+static unsigned long const TRANSACTION_MS = 5;
+static unsigned long const BYTES_PER_SECOND = 40000;
+
+static size_t const PAYLOAD_SIZES[] = { 256, 1024, 4096, 8192 };
+static unsigned int const WRITES = 20;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+struct WriteCost
+{
+  unsigned long ms;
+  unsigned long wire_bytes;
+  unsigned long transactions;
+};
+
+/* Simulated time and bus traffic of a single write() of the given size */
+static void writeCost(size_t const size, uint32_t const binary_threshold, WriteCost & cost)
+{
+  setFakeMillis(1000);
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setBinaryTransferThreshold(binary_threshold);
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  NotecardDevice.transaction_ms = TRANSACTION_MS;
+  NotecardDevice.bytes_per_second = BYTES_PER_SECOND;
+  NotecardDevice.outbound.clear();
+  unsigned long const wire_bytes = NotecardDevice.wire_bytes;
+  unsigned long const transactions = NotecardDevice.transactions;
+  unsigned long const start = millis();
+
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; i++) payload[i] = i * 7;
+  for (unsigned int n = 0; n < WRITES; n++)
+    REQUIRE_EQUAL(handler.write(payload.data(), payload.size()), NotecardConnectionHandler::NOTECARD_ERROR_NONE);
+
+  /* Every Note carries the whole payload, through the expected path */
+  REQUIRE_EQUAL(NotecardDevice.outbound.size(), WRITES);
+  for (auto const & note : NotecardDevice.outbound)
+  {
+    REQUIRE_EQUAL(note.size, size);
+    REQUIRE_EQUAL(note.binary, binary_threshold && (size >= binary_threshold));
+  }
+
+  cost = WriteCost{(millis() - start) / WRITES,
+                   (NotecardDevice.wire_bytes - wire_bytes) / WRITES,
+                   (NotecardDevice.transactions - transactions) / WRITES};
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(binary_write_throughput)
+{
+  for (size_t const size : PAYLOAD_SIZES)
+  {
+    WriteCost base64, binary;
+    writeCost(size, 0, base64);
+    writeCost(size, 1, binary);
+    printf("%5zu bytes: base64 %4lu ms %5lu wire bytes %2lu transactions (%5.1f kB/s), "
+           "binary %4lu ms %5lu wire bytes %2lu transactions (%5.1f kB/s)\n",
+           size,
+           base64.ms, base64.wire_bytes, base64.transactions, size / (double)base64.ms,
+           binary.ms, binary.wire_bytes, binary.transactions, size / (double)binary.ms);
+
+    /* The base64 inflation of a third is not sent over the bus */
+    REQUIRE(binary.wire_bytes < base64.wire_bytes);
+    /* The extra card.binary.put transaction pays off for multi-kilobyte bursts */
+    if (size >= 4096)
+      REQUIRE(binary.ms < base64.ms);
+  }
+}
+
+TEST_CASE(threshold_selects_the_path)
+{
+  WriteCost cost;
+  writeCost(1023, 1024, cost);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("card.binary.put"), 0);
+  writeCost(1024, 1024, cost);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("card.binary.put"), WRITES);
+}
+
+TEST_MAIN()
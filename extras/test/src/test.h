@@ -0,0 +1,133 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+/* Minimal test and benchmark helpers of the host build, so that it does not
+ * depend on any third party framework. Every test executable defines its test
+ * cases with TEST_CASE() and runs them with TEST_MAIN().
+ */
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdio.h>
+
+#include <chrono>
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+#define TEST_CASE(name)                                                       \
+  static void name();                                                         \
+  static TestCase name##_test_case(#name, name);                              \
+  static void name()
+
+#define REQUIRE(condition)                                                    \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      TestCase::fail(__FILE__, __LINE__, #condition);                         \
+      return;                                                                 \
+    }                                                                         \
+  } while (0)
+
+#define REQUIRE_EQUAL(actual, expected)                                       \
+  do {                                                                        \
+    long long const actual_value = static_cast<long long>(actual);            \
+    long long const expected_value = static_cast<long long>(expected);        \
+    if (actual_value != expected_value) {                                     \
+      TestCase::fail(__FILE__, __LINE__, #actual " == " #expected);           \
+      printf("    actual: %lld, expected: %lld\n", actual_value, expected_value); \
+      return;                                                                 \
+    }                                                                         \
+  } while (0)
+
+#define TEST_MAIN()                                                           \
+  int main() {                                                                \
+    return TestCase::runAll();                                                \
+  }
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class TestCase
+{
+  public:
+
+    TestCase(char const * name, void (*function)())
+    : _name{name}
+    , _function{function}
+    , _next{nullptr}
+    {
+      /* Keep the test cases in the order of definition */
+      TestCase ** tail = &head();
+      while (*tail) tail = &(*tail)->_next;
+      *tail = this;
+    }
+
+    static void fail(char const * file, int const line, char const * condition)
+    {
+      printf("    %s:%d: REQUIRE(%s) failed\n", file, line, condition);
+      failed() = true;
+    }
+
+    static int runAll()
+    {
+      int failures = 0;
+      for (TestCase * test = head(); test; test = test->_next)
+      {
+        failed() = false;
+        printf("[ RUN      ] %s\n", test->_name);
+        test->_function();
+        printf("%s %s\n", failed() ? "[  FAILED  ]" : "[       OK ]", test->_name);
+        if (failed()) failures++;
+      }
+      return failures;
+    }
+
+  private:
+
+    char const * _name;
+    void (*_function)();
+    TestCase * _next;
+
+    static TestCase * & head() { static TestCase * h = nullptr; return h; }
+    static bool & failed() { static bool f = false; return f; }
+};
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Wall clock time of a single call of the function, averaged over the given
+ * number of iterations, in nanoseconds.
+ */
+template <typename Function>
+double benchmarkNanoseconds(unsigned long const iterations, Function function)
+{
+  auto const start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < iterations; i++)
+    function();
+  auto const stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+#endif /* TEST_TEST_H_ */
@@ -0,0 +1,124 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static char const PIN[] = "0000";
+static char const APN[] = "apn.example";
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetCellularNetwork(bool const network_available)
+{
+  CellularNetwork = CellularSimulation();
+  CellularNetwork.network_available = network_available;
+  CellularNetwork.registration_ms = 15000;
+  CellularNetwork.attach_ms = 3000;
+  CellularNetwork.begin_timeout_ms = 30000;
+  GSM = GSMClass();
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(bring_up)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true);
+  CatM1ConnectionHandler handler(PIN, APN, "", "");
+
+  /* The GSM library only has a blocking begin(): registration plus attach */
+  CheckDuration const duration = maxCheckDuration(handler, 30000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE(handler.getStage() == CatM1ConnectionHandler::Stage::CONNECTED);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 18000);
+  REQUIRE_EQUAL(handler.getRegistrationAttempts(), 1);
+  REQUIRE_EQUAL(handler.getLastRegistrationDuration(), 18000);
+  REQUIRE_EQUAL(GSM.restarts, 1);
+}
+
+TEST_CASE(failed_registration_is_retried_with_backoff)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(false);
+  CatM1ConnectionHandler handler(PIN, APN, "", "");
+
+  /* Every attempt blocks for the 30 s timeout of begin(), then waits for the
+   * backoff: 2.5-5 s, 5-10 s, 10-20 s, ... (jitter of 50 %)
+   */
+  CheckDuration const duration = maxCheckDuration(handler, 600000);
+  printf("10 min without network: %u registration attempts, longest check() %lu ms\n",
+         handler.getRegistrationAttempts(), duration.max_blocking_ms);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE(handler.getStage() == CatM1ConnectionHandler::Stage::RETRY_WAIT);
+  REQUIRE(handler.getRegistrationAttempts() >= 6 && handler.getRegistrationAttempts() <= 12);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 30000);
+  /* Only the first attempt restarts the modem */
+  REQUIRE_EQUAL(GSM.restarts, 1);
+
+  CellularNetwork.network_available = true;
+  maxCheckDuration(handler, 400000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(backoff_can_be_disabled)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(false);
+  CatM1ConnectionHandler handler(PIN, APN, "", "");
+  handler.disableReconnectBackoff();
+
+  /* Retried at the CONNECTING check interval */
+  maxCheckDuration(handler, 600000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE(handler.getRegistrationAttempts() >= 19);
+}
+
+TEST_CASE(connection_loss)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true);
+  CatM1ConnectionHandler handler(PIN, APN, "", "");
+  maxCheckDuration(handler, 30000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  CellularNetwork.network_available = false;
+  maxCheckDuration(handler, 11000);
+  REQUIRE(handler.getStage() != CatM1ConnectionHandler::Stage::CONNECTED);
+
+  CellularNetwork.network_available = true;
+  maxCheckDuration(handler, 120000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(GSM.restarts, 2);
+}
+
+TEST_MAIN()
@@ -0,0 +1,107 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+#include <type_traits>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* A plain aggregate, so that the tables are constant initialized (in flash) */
+static_assert(std::is_trivial<CheckIntervalTable>::value, "CheckIntervalTable must be trivial");
+static_assert(std::is_standard_layout<CheckIntervalTable>::value, "CheckIntervalTable must be standard layout");
+
+static CheckIntervalTable const CUSTOM_CHECK_INTERVAL_TABLE =
+{{
+  /* INIT          */ 1,
+  /* CONNECTING    */ 2,
+  /* CONNECTED     */ 3,
+  /* DISCONNECTING */ 4,
+  /* DISCONNECTED  */ 5,
+  /* CLOSED        */ 6,
+  /* ERROR         */ 7
+}};
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(default_intervals)
+{
+  FakeConnectionHandler handler;
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::INIT),          100);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::CONNECTING),    500);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::CONNECTED),     10000);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::DISCONNECTING), 100);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::DISCONNECTED),  1000);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::CLOSED),        1000);
+  REQUIRE_EQUAL(handler.getCheckInterval(NetworkConnectionState::ERROR),         1000);
+}
+
+TEST_CASE(table_indexed_by_state)
+{
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+  {
+    NetworkConnectionState const state = static_cast<NetworkConnectionState>(s);
+    REQUIRE_EQUAL(CUSTOM_CHECK_INTERVAL_TABLE[state], s + 1);
+    REQUIRE_EQUAL(CUSTOM_CHECK_INTERVAL_TABLE.intervals[s], s + 1);
+  }
+
+  CheckIntervalTable table = CUSTOM_CHECK_INTERVAL_TABLE;
+  table[NetworkConnectionState::CONNECTED] = 60000;
+  REQUIRE_EQUAL(table.intervals[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)], 60000);
+  REQUIRE_EQUAL(table[NetworkConnectionState::CONNECTING], 2);
+}
+
+TEST_CASE(intervals_per_instance)
+{
+  FakeConnectionHandler battery_node;
+  FakeConnectionHandler gateway;
+
+  battery_node.setCheckInterval(NetworkConnectionState::CONNECTED, 60000);
+  gateway.setCheckIntervalTable(CUSTOM_CHECK_INTERVAL_TABLE);
+
+  REQUIRE_EQUAL(battery_node.getCheckInterval(NetworkConnectionState::CONNECTED), 60000);
+  REQUIRE_EQUAL(battery_node.getCheckInterval(NetworkConnectionState::CONNECTING), 500);
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    REQUIRE_EQUAL(gateway.getCheckInterval(static_cast<NetworkConnectionState>(s)), s + 1);
+
+  /* The defaults shared by the other instances are left untouched */
+  FakeConnectionHandler other;
+  REQUIRE_EQUAL(other.getCheckInterval(NetworkConnectionState::CONNECTED), 10000);
+  REQUIRE_EQUAL(DEFAULT_CHECK_INTERVAL_TABLE[NetworkConnectionState::CONNECTED], 10000);
+}
+
+TEST_CASE(deprecated_table_alias)
+{
+  /* Sketches indexing the former CHECK_INTERVAL_TABLE still build */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    REQUIRE_EQUAL(CHECK_INTERVAL_TABLE[s], DEFAULT_CHECK_INTERVAL_TABLE.intervals[s]);
+  REQUIRE_EQUAL(CHECK_INTERVAL_TABLE[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)], 10000);
+#pragma GCC diagnostic pop
+}
+
+TEST_MAIN()
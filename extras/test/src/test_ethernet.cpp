@@ -0,0 +1,162 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+#include <string>
+
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Counts the logged messages containing the given text */
+class LogCounter : public Print
+{
+  public:
+    LogCounter(char const * text) : count{0}, _text{text} { Debug.setDebugOutputStream(this); }
+    ~LogCounter() { Debug.setDebugOutputStream(nullptr); }
+
+    unsigned int count;
+
+    virtual size_t write(uint8_t c) override
+    {
+      if (c != '\n') {
+        _line += static_cast<char>(c);
+      } else {
+        if (_line.find(_text) != std::string::npos) count++;
+        _line.clear();
+      }
+      return 1;
+    }
+    using Print::write;
+
+  private:
+    std::string const _text;
+    std::string _line;
+};
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetEthernet(bool const cable_plugged, unsigned long const configuration_ms)
+{
+  Ethernet = EthernetClass();
+  Ethernet.cable_plugged = cable_plugged;
+  Ethernet.configuration_ms = configuration_ms;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(link_status_unknown_before_begin)
+{
+  /* The link is reported OFF until begin() has been called */
+  setFakeMillis(1000);
+  resetEthernet(true, 1500);
+  EthernetConnectionHandler handler;
+
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(Ethernet.begin_calls, 1);
+}
+
+TEST_CASE(unplugged_cable)
+{
+  setFakeMillis(1000);
+  resetEthernet(false, 1500);
+  EthernetConnectionHandler handler;
+  handler.setConfigurationTimeout(2000, 500);
+  LogCounter link_off("link OFF");
+
+  /* Only the first attempt, before the link status is known, waits for the
+   * configuration to time out. The error is logged once.
+   */
+  CheckDuration const duration = maxCheckDuration(handler, 60000);
+  printf("unplugged for 60 s: %u begin() calls, longest check() %lu ms\n", Ethernet.begin_calls, duration.max_blocking_ms);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE_EQUAL(Ethernet.begin_calls, 1);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 2000);
+  REQUIRE_EQUAL(link_off.count, 1);
+
+  Ethernet.cable_plugged = true;
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(cable_pulled_while_connected)
+{
+  setFakeMillis(1000);
+  resetEthernet(true, 1500);
+  EthernetConnectionHandler handler;
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  LogCounter link_off("link OFF");
+  unsigned int const begin_calls = Ethernet.begin_calls;
+  Ethernet.cable_plugged = false;
+  CheckDuration const duration = maxCheckDuration(handler, 60000);
+
+  /* The loss is logged, the repeated link down checks while reconnecting are not */
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE_EQUAL(Ethernet.begin_calls, begin_calls);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 0);
+  REQUIRE_EQUAL(link_off.count, 1);
+
+  Ethernet.cable_plugged = true;
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(worst_case_check_duration)
+{
+  struct
+  {
+    char const * name;
+    bool dhcp_available;
+    unsigned long timeout_ms;
+  } const SCENARIOS[] =
+  {
+    { "DHCP in 3 s",                true,  15000 },
+    { "no DHCP, default timeout",   false, 15000 },
+    { "no DHCP, 2 s timeout",       false, 2000  },
+  };
+
+  for (auto const & scenario : SCENARIOS)
+  {
+    setFakeMillis(1000);
+    resetEthernet(true, 3000);
+    Ethernet.dhcp_available = scenario.dhcp_available;
+    EthernetConnectionHandler handler;
+    handler.setConfigurationTimeout(scenario.timeout_ms, 500);
+
+    CheckDuration const duration = maxCheckDuration(handler, 60000);
+    printf("%-26s: longest check() %5lu ms\n", scenario.name, duration.max_blocking_ms);
+    REQUIRE_EQUAL(duration.max_blocking_ms, scenario.dhcp_available ? 3000 : scenario.timeout_ms);
+  }
+}
+
+TEST_MAIN()
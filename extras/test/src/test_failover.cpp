@@ -0,0 +1,176 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const MAX_STEPS = 1000000;
+static uint32_t const FAILBACK_STABLE_MS = 5000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Advances the fake clock by 1 ms per check() until the failover handler is
+ * connected through the given link, and returns the time it took (0 if it
+ * never happened).
+ */
+static unsigned long runUntilConnectedThrough(FailoverConnectionHandler & failover, ConnectionHandler & link)
+{
+  for (unsigned long i = 1; i <= MAX_STEPS; i++)
+  {
+    advanceFakeMillis(1);
+    if (failover.check() == NetworkConnectionState::CONNECTED && failover.getActiveHandler() == &link)
+      return i;
+  }
+  return 0;
+}
+
+static bool runUntil(FailoverConnectionHandler & failover, NetworkConnectionState const state)
+{
+  for (unsigned long i = 0; i < MAX_STEPS; i++)
+  {
+    advanceFakeMillis(1);
+    if (failover.check() == state)
+      return true;
+  }
+  return false;
+}
+
+/* Measures the time from the loss of the primary link until the failover
+ * handler is connected through the secondary one.
+ */
+static unsigned long measureFailoverLatency(uint32_t const link_connected_interval_ms)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler primary, secondary;
+  primary.setCheckInterval(NetworkConnectionState::CONNECTED, link_connected_interval_ms);
+  secondary.setCheckInterval(NetworkConnectionState::CONNECTED, link_connected_interval_ms);
+  FailoverConnectionHandler failover(primary, secondary, FAILBACK_STABLE_MS);
+
+  primary.link_up = true;
+  secondary.link_up = true;
+  if (!runUntilConnectedThrough(failover, primary))
+    return 0;
+  /* Let the secondary link connect as well */
+  if (!runUntil(failover, NetworkConnectionState::CONNECTED))
+    return 0;
+  advanceFakeMillis(link_connected_interval_ms);
+  failover.check();
+
+  primary.link_up = false;
+  return runUntilConnectedThrough(failover, secondary);
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(failover_latency)
+{
+  /* The loss is noticed at the next CONNECTED check of the active link, the
+   * failover handler then needs a DISCONNECTED, INIT and CONNECTING tick.
+   */
+  uint32_t const LINK_CONNECTED_INTERVALS[] = { 10000, 1000, 100 };
+  for (uint32_t const interval : LINK_CONNECTED_INTERVALS)
+  {
+    unsigned long const latency = measureFailoverLatency(interval);
+    printf("link CONNECTED interval %5u ms: failover latency %5lu ms\n", interval, latency);
+    REQUIRE(latency > 0);
+    REQUIRE(latency <= interval + 1 + 4 * 101);
+  }
+}
+
+TEST_CASE(failback_once_stable)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler primary, secondary;
+  FailoverConnectionHandler failover(primary, secondary, FAILBACK_STABLE_MS);
+
+  secondary.link_up = true;
+  REQUIRE(runUntilConnectedThrough(failover, secondary) > 0);
+
+  primary.link_up = true;
+  unsigned long const latency = runUntilConnectedThrough(failover, primary);
+  printf("failback latency %lu ms (stable period %u ms)\n", latency, FAILBACK_STABLE_MS);
+  REQUIRE(latency >= FAILBACK_STABLE_MS);
+  REQUIRE(latency <= FAILBACK_STABLE_MS + 2000);
+}
+
+TEST_CASE(reconnect_after_disconnect)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler primary, secondary;
+  FailoverConnectionHandler failover(primary, secondary, FAILBACK_STABLE_MS);
+
+  primary.link_up = true;
+  secondary.link_up = true;
+  REQUIRE(runUntilConnectedThrough(failover, primary) > 0);
+
+  /* The failover handler is CLOSED before its links are */
+  failover.disconnect();
+  REQUIRE(runUntil(failover, NetworkConnectionState::CLOSED));
+  REQUIRE(primary.currentState() != NetworkConnectionState::CONNECTED);
+  REQUIRE(secondary.currentState() != NetworkConnectionState::CONNECTED);
+
+  failover.connect();
+  REQUIRE(runUntilConnectedThrough(failover, primary) > 0);
+
+  /* And once more after the links have been CLOSED too */
+  failover.disconnect();
+  REQUIRE(runUntil(failover, NetworkConnectionState::CLOSED));
+  advanceFakeMillis(10000);
+  primary.check();
+  secondary.check();
+  REQUIRE(primary.currentState() == NetworkConnectionState::CLOSED);
+  REQUIRE(secondary.currentState() == NetworkConnectionState::CLOSED);
+
+  failover.connect();
+  REQUIRE(runUntilConnectedThrough(failover, primary) > 0);
+  REQUIRE(secondary.currentState() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(loss_does_not_restart_connected_links)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler primary, secondary;
+  FailoverConnectionHandler failover(primary, secondary, FAILBACK_STABLE_MS);
+
+  primary.link_up = true;
+  secondary.link_up = true;
+  REQUIRE(runUntilConnectedThrough(failover, primary) > 0);
+  REQUIRE(runUntil(failover, NetworkConnectionState::CONNECTED));
+  advanceFakeMillis(10000);
+  failover.check();
+  REQUIRE(secondary.currentState() == NetworkConnectionState::CONNECTED);
+
+  unsigned int const secondary_inits = secondary.handled[static_cast<unsigned int>(NetworkConnectionState::INIT)];
+  primary.link_up = false;
+  REQUIRE(runUntilConnectedThrough(failover, secondary) > 0);
+  REQUIRE_EQUAL(secondary.handled[static_cast<unsigned int>(NetworkConnectionState::INIT)], secondary_inits);
+}
+
+TEST_MAIN()
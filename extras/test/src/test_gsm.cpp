@@ -0,0 +1,116 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static char const PIN[] = "0000";
+static char const APN[] = "apn.example";
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetCellularNetwork(bool const network_available, unsigned long const registration_ms)
+{
+  CellularNetwork = CellularSimulation();
+  CellularNetwork.network_available = network_available;
+  CellularNetwork.registration_ms = registration_ms;
+  CellularNetwork.attach_ms = 2000;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(connect_without_blocking)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 20000);
+  GSMConnectionHandler handler(PIN, APN, "", "");
+
+  /* Registration and attach are polled, only the ping blocks */
+  CellularNetwork.ping_ms = 300;
+  CheckDuration const duration = maxCheckDuration(handler, 30000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 300);
+  REQUIRE(handler.getSimUnlockDuration() >= 20000 && handler.getSimUnlockDuration() < 20200);
+  REQUIRE(handler.getGprsAttachDuration() >= 2000 && handler.getGprsAttachDuration() < 2200);
+  REQUIRE_EQUAL(CellularNetwork.begin_calls, 1);
+}
+
+TEST_CASE(slow_registration_is_retried)
+{
+  /* No network for 10 minutes: the registration keeps being retried, the
+   * handler is not sent to the (terminal) ERROR state.
+   */
+  setFakeMillis(1000);
+  resetCellularNetwork(false, 20000);
+  GSMConnectionHandler handler(PIN, APN, "", "");
+
+  CheckDuration duration = maxCheckDuration(handler, 600000);
+  REQUIRE(handler.check() == NetworkConnectionState::INIT);
+  REQUIRE(CellularNetwork.begin_calls >= 3);
+  REQUIRE(duration.max_blocking_ms == 0);
+
+  /* Registration taking longer than the former 30 s timeout */
+  CellularNetwork.network_available = true;
+  CellularNetwork.registration_ms = 90000;
+  duration = maxCheckDuration(handler, 400000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE(handler.getSimUnlockDuration() >= 90000);
+}
+
+TEST_CASE(wrong_pin_is_an_error)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 0);
+  CellularNetwork.pin_valid = false;
+  GSMConnectionHandler handler(PIN, APN, "", "");
+
+  maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::ERROR);
+  REQUIRE_EQUAL(CellularNetwork.begin_calls, 1);
+}
+
+TEST_CASE(attach_timeout_is_retried)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 0);
+  CellularNetwork.gprs_available = false;
+  GSMConnectionHandler handler(PIN, APN, "", "");
+
+  maxCheckDuration(handler, 100000);
+  REQUIRE(handler.check() == NetworkConnectionState::INIT);
+  REQUIRE(CellularNetwork.attach_calls >= 2);
+
+  CellularNetwork.gprs_available = true;
+  maxCheckDuration(handler, 60000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_MAIN()
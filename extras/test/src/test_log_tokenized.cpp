@@ -0,0 +1,119 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "test.h"
+
+#include <Arduino_ConnectionHandlerLog.h>
+
+#include <string>
+#include <vector>
+
+/* Built with CONNECTION_HANDLER_LOG_TOKENIZED. The frames written by
+ * decodable_frames are decoded by extras/tools/decode_log.py in the
+ * test_log_tokenized_decode test.
+ */
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+class CapturePrint : public Print
+{
+  public:
+    std::vector<uint8_t> bytes;
+    virtual size_t write(uint8_t c) override { bytes.push_back(c); return 1; }
+    using Print::write;
+};
+
+class StdoutPrint : public Print
+{
+  public:
+    virtual size_t write(uint8_t c) override { return (fputc(c, stdout) != EOF) ? 1 : 0; }
+    using Print::write;
+};
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(frame_layout)
+{
+  CapturePrint capture;
+  ConnectionHandlerLog::setOutput(capture);
+  int notes = 3, size = 120;
+  CH_LOG_DEBUG("Synced %d Notes (%d bytes)", notes, size);
+
+  /* Sync, level, payload length, little endian token and arguments */
+  uint32_t const token = ConnectionHandlerLog::token("Synced %d Notes (%d bytes)");
+  std::vector<uint8_t> const expected = {
+    0xA5, DBG_DEBUG, 8,
+    static_cast<uint8_t>(token), static_cast<uint8_t>(token >> 8), static_cast<uint8_t>(token >> 16), static_cast<uint8_t>(token >> 24),
+    3, 0, 0, 0,
+    120, 0, 0, 0
+  };
+  REQUIRE(capture.bytes == expected);
+}
+
+TEST_CASE(string_arguments_are_length_prefixed)
+{
+  CapturePrint capture;
+  ConnectionHandlerLog::setOutput(capture);
+  CH_LOG_ERROR("Error: %s", "io");
+
+  REQUIRE_EQUAL(capture.bytes.size(), 10);
+  REQUIRE_EQUAL(capture.bytes[2], 3);
+  REQUIRE_EQUAL(capture.bytes[7], 2);
+  REQUIRE_EQUAL(capture.bytes[8], 'i');
+  REQUIRE_EQUAL(capture.bytes[9], 'o');
+}
+
+TEST_CASE(frame_is_truncated_at_64_bytes)
+{
+  CapturePrint capture;
+  ConnectionHandlerLog::setOutput(capture);
+  std::string const context(80, 'x');
+  int allocated = 1024;
+  CH_LOG_DEBUG("[MEMORY][%s %s] Allocated: %d bytes", ">>>>", context.c_str(), allocated);
+
+  /* The second string is cut, the integer does not fit anymore */
+  REQUIRE_EQUAL(capture.bytes.size(), ConnectionHandlerLog::FRAME_MAX_SIZE);
+  REQUIRE_EQUAL(capture.bytes[2], ConnectionHandlerLog::FRAME_MAX_SIZE - ConnectionHandlerLog::FRAME_HEADER_SIZE);
+  REQUIRE_EQUAL(capture.bytes[7], 4);
+  REQUIRE_EQUAL(capture.bytes[12], ConnectionHandlerLog::FRAME_MAX_SIZE - 13);
+}
+
+TEST_CASE(decodable_frames)
+{
+  /* Written amidst the text output of the test, as a serial log would be */
+  StdoutPrint out;
+  ConnectionHandlerLog::setOutput(out);
+  std::string const context(80, 'x');
+  int notes = 3, size = 120, allocated = 1024;
+  CH_LOG_INFO("Message sent correctly!");
+  CH_LOG_DEBUG("Synced %d Notes (%d bytes)", notes, size);
+  CH_LOG_ERROR("Error: %s", "io");
+  CH_LOG_DEBUG("[MEMORY][%s %s] Allocated: %d bytes", ">>>>", context.c_str(), allocated);
+  CH_LOG_INFO("Registration attempt %u failed after %lu milliseconds, retrying", 2u, 180000ul);
+  fflush(stdout);
+}
+
+TEST_MAIN()
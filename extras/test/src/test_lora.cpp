@@ -0,0 +1,106 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static char const APPEUI[] = "0000000000000000";
+static char const APPKEY[] = "00000000000000000000000000000000";
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetLoRaNetwork(bool const network_available, unsigned long const join_ms)
+{
+  LoRaNetwork = LoRaSimulation();
+  LoRaNetwork.begin_ms = 20;
+  LoRaNetwork.network_available = network_available;
+  LoRaNetwork.join_ms = join_ms;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(init_does_not_block)
+{
+  setFakeMillis(1000);
+  resetLoRaNetwork(true, 0);
+  LoRaConnectionHandler handler(APPEUI, APPKEY);
+
+  /* Only begin() itself blocks, the chip settles in between the checks */
+  CheckDuration const duration = maxCheckDuration(handler, 2000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(duration.max_blocking_ms, LoRaNetwork.begin_ms);
+  REQUIRE_EQUAL(LoRaNetwork.begin_calls, 1);
+  REQUIRE_EQUAL(LoRaNetwork.join_calls, 1);
+}
+
+TEST_CASE(failed_join_retries_without_begin)
+{
+  setFakeMillis(1000);
+  resetLoRaNetwork(false, 0);
+  LoRaConnectionHandler handler(APPEUI, APPKEY);
+  handler.setJoinTimeout(5000);
+
+  maxCheckDuration(handler, 60000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE_EQUAL(LoRaNetwork.begin_calls, 1);
+  REQUIRE(LoRaNetwork.join_calls > 5);
+  REQUIRE_EQUAL(handler.getLastJoinDuration(), 5000);
+
+  LoRaNetwork.network_available = true;
+  LoRaNetwork.join_ms = 3000;
+  maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(LoRaNetwork.begin_calls, 1);
+  REQUIRE_EQUAL(handler.getLastJoinDuration(), 3000);
+}
+
+TEST_CASE(check_within_budget)
+{
+  /* The join can not be split any further with the MKRWAN API, hence the
+   * budget of a check() is the join timeout.
+   */
+  uint32_t const BUDGETS_MS[] = { 2000, 10000, 60000 };
+  for (uint32_t const budget : BUDGETS_MS)
+  {
+    setFakeMillis(1000);
+    resetLoRaNetwork(false, 0);
+    LoRaConnectionHandler handler(APPEUI, APPKEY);
+    handler.setJoinTimeout(budget);
+
+    CheckDuration const duration = maxCheckDuration(handler, 300000);
+    printf("budget %5u ms: %u join attempts in 300 s, longest check() %5lu ms\n", budget, LoRaNetwork.join_calls, duration.max_blocking_ms);
+    REQUIRE(duration.max_blocking_ms <= budget);
+    REQUIRE_EQUAL(LoRaNetwork.begin_calls, 1);
+  }
+}
+
+TEST_MAIN()
@@ -0,0 +1,180 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned int const INIT = static_cast<unsigned int>(NetworkConnectionState::INIT);
+static unsigned int const CONNECTING = static_cast<unsigned int>(NetworkConnectionState::CONNECTING);
+static unsigned int const CONNECTED = static_cast<unsigned int>(NetworkConnectionState::CONNECTED);
+static unsigned int const DISCONNECTING = static_cast<unsigned int>(NetworkConnectionState::DISCONNECTING);
+static unsigned int const DISCONNECTED = static_cast<unsigned int>(NetworkConnectionState::DISCONNECTED);
+static unsigned int const CLOSED = static_cast<unsigned int>(NetworkConnectionState::CLOSED);
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Calls check() every millisecond until the handler reaches the given state,
+ * or duration_ms has elapsed, and returns the time of the last transition.
+ */
+static uint32_t runUntil(FakeConnectionHandler & handler, NetworkConnectionState const state, unsigned long const duration_ms)
+{
+  for (unsigned long t = 0; t < duration_ms && handler.check() != state; t++)
+    advanceFakeMillis(1);
+  return handler.getMetrics().last_transition_ms;
+}
+
+/* The dwell times, plus the time spent in the current state, add up to the
+ * time elapsed since the metrics were reset.
+ */
+static uint32_t accountedTime(FakeConnectionHandler & handler)
+{
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  uint32_t total = static_cast<uint32_t>(millis()) - metrics.last_transition_ms;
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    total += metrics.dwell_ms[s];
+  return total;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(bring_up)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+
+  uint32_t const connected_ms = runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+  advanceFakeMillis(5000);
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(metrics.entries[INIT], 1);
+  REQUIRE_EQUAL(metrics.entries[CONNECTING], 1);
+  REQUIRE_EQUAL(metrics.entries[CONNECTED], 1);
+  REQUIRE_EQUAL(metrics.dwell_ms[INIT] + metrics.dwell_ms[CONNECTING], connected_ms - 1000);
+  REQUIRE_EQUAL(metrics.dwell_ms[CONNECTED], 0);
+  REQUIRE_EQUAL(metrics.time_to_connect[0], 1);
+  REQUIRE_EQUAL(metrics.longest_outage_ms, 0);
+  REQUIRE_EQUAL(accountedTime(handler), millis() - 1000);
+}
+
+TEST_CASE(outages)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+
+  /* Link down for 30 s, then for 3 s: the longest outage is the first one */
+  unsigned long const DOWN_MS[] = { 30000, 3000 };
+  uint32_t outage_ms[2];
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    handler.link_up = false;
+    uint32_t const lost_ms = runUntil(handler, NetworkConnectionState::DISCONNECTED, 20000);
+    advanceFakeMillis(DOWN_MS[i]);
+    handler.link_up = true;
+    outage_ms[i] = runUntil(handler, NetworkConnectionState::CONNECTED, 20000) - lost_ms;
+  }
+
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  printf("outages of %u ms and %u ms\n", outage_ms[0], outage_ms[1]);
+  REQUIRE(outage_ms[0] >= 30000);
+  REQUIRE(outage_ms[1] >= 3000 && outage_ms[1] < 4000);
+  REQUIRE_EQUAL(metrics.longest_outage_ms, outage_ms[0]);
+  REQUIRE_EQUAL(metrics.entries[CONNECTED], 3);
+  REQUIRE_EQUAL(metrics.entries[DISCONNECTED], 2);
+  /* < 1 s for the bring-up, < 64 s and < 4 s for the reconnections */
+  REQUIRE_EQUAL(metrics.time_to_connect[0], 1);
+  REQUIRE_EQUAL(metrics.time_to_connect[1], 1);
+  REQUIRE_EQUAL(metrics.time_to_connect[3], 1);
+  /* The outages are spent in DISCONNECTED, INIT and CONNECTING */
+  REQUIRE(metrics.dwell_ms[DISCONNECTED] + metrics.dwell_ms[INIT] + metrics.dwell_ms[CONNECTING] >= outage_ms[0] + outage_ms[1]);
+  REQUIRE_EQUAL(accountedTime(handler), millis() - 1000);
+}
+
+TEST_CASE(user_disconnect_is_not_an_outage)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+
+  handler.disconnect();
+  runUntil(handler, NetworkConnectionState::CLOSED, 10000);
+  advanceFakeMillis(60000);
+  handler.connect();
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  REQUIRE_EQUAL(metrics.longest_outage_ms, 0);
+  REQUIRE_EQUAL(metrics.entries[DISCONNECTING], 1);
+  REQUIRE_EQUAL(metrics.entries[CLOSED], 1);
+  REQUIRE(metrics.dwell_ms[CLOSED] >= 60000);
+  REQUIRE_EQUAL(metrics.time_to_connect[0], 2);
+  REQUIRE_EQUAL(accountedTime(handler), millis() - 1000);
+}
+
+TEST_CASE(reset)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+  advanceFakeMillis(5000);
+
+  handler.resetMetrics();
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+  {
+    REQUIRE_EQUAL(metrics.dwell_ms[s], 0);
+    REQUIRE_EQUAL(metrics.entries[s], (s == CONNECTED) ? 1 : 0);
+  }
+  REQUIRE_EQUAL(metrics.last_transition_ms, millis());
+  REQUIRE_EQUAL(accountedTime(handler), 0);
+}
+
+TEST_CASE(millis_rollover)
+{
+  /* 32 bit millis() wraps around on the target while connecting */
+  setFakeMillis(0xFFFFFFFFUL - 200);
+  FakeConnectionHandler handler;
+  handler.link_up = false;
+  runUntil(handler, NetworkConnectionState::CONNECTING, 1000);
+  advanceFakeMillis(3000);
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+
+  ConnectionMetrics const & metrics = handler.getMetrics();
+  REQUIRE(metrics.dwell_ms[CONNECTING] >= 3000 && metrics.dwell_ms[CONNECTING] < 4000);
+  REQUIRE_EQUAL(metrics.time_to_connect[1], 1);
+  REQUIRE_EQUAL(accountedTime(handler), static_cast<uint32_t>(millis() - (0xFFFFFFFFUL - 200)));
+}
+
+TEST_MAIN()
@@ -0,0 +1,137 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static char const PIN[] = "0000";
+static char const APN[] = "apn.example";
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetCellularNetwork(bool const network_available, unsigned long const registration_ms)
+{
+  CellularNetwork = CellularSimulation();
+  CellularNetwork.network_available = network_available;
+  CellularNetwork.registration_ms = registration_ms;
+  CellularNetwork.attach_ms = 5000;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(check_within_budget)
+{
+  /* SIM unlock, registration and attach are all polled: no check() blocks */
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 60000);
+  NBConnectionHandler handler(PIN, APN);
+
+  CheckDuration const duration = maxCheckDuration(handler, 90000);
+  printf("bring-up: %lu check() calls, longest %lu ms, registration %lu ms, attach %lu ms\n",
+         duration.calls, duration.max_blocking_ms, handler.getRegistrationDuration(), handler.getGprsAttachDuration());
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 0);
+  REQUIRE(handler.getRegistrationDuration() >= 60000 && handler.getRegistrationDuration() < 60200);
+  REQUIRE(handler.getGprsAttachDuration() >= 5000 && handler.getGprsAttachDuration() < 5600);
+  REQUIRE_EQUAL(CellularNetwork.begin_calls, 1);
+  REQUIRE_EQUAL(CellularNetwork.attach_calls, 1);
+}
+
+TEST_CASE(registration_timeout)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(false, 0);
+  NBConnectionHandler handler(PIN, APN);
+  handler.setAttachTimeouts(20000, 10000);
+
+  /* One registration every 20 s (plus the INIT check interval) */
+  CheckDuration const duration = maxCheckDuration(handler, 100000);
+  REQUIRE(handler.check() == NetworkConnectionState::INIT);
+  REQUIRE_EQUAL(duration.max_blocking_ms, 0);
+  REQUIRE(CellularNetwork.begin_calls >= 4 && CellularNetwork.begin_calls <= 5);
+  REQUIRE(handler.getRegistrationDuration() <= 20100);
+
+  CellularNetwork.network_available = true;
+  maxCheckDuration(handler, 30000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(attach_timeout)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 0);
+  CellularNetwork.gprs_available = false;
+  NBConnectionHandler handler(PIN, APN);
+  handler.setAttachTimeouts(20000, 10000);
+
+  /* The attach is retried without registering again */
+  maxCheckDuration(handler, 60000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE_EQUAL(CellularNetwork.begin_calls, 1);
+  REQUIRE(CellularNetwork.attach_calls >= 5);
+
+  CellularNetwork.gprs_available = true;
+  maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(wrong_pin_is_an_error)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 0);
+  CellularNetwork.pin_valid = false;
+  NBConnectionHandler handler(PIN, APN);
+
+  maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::ERROR);
+}
+
+TEST_CASE(connection_loss)
+{
+  setFakeMillis(1000);
+  resetCellularNetwork(true, 1000);
+  NBConnectionHandler handler(PIN, APN);
+  maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  CellularNetwork.network_available = false;
+  maxCheckDuration(handler, 11000);
+  REQUIRE(handler.check() == NetworkConnectionState::INIT);
+  REQUIRE_EQUAL(CellularNetwork.shutdown_calls, 0);
+
+  CellularNetwork.network_available = true;
+  maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(CellularNetwork.begin_calls, 2);
+}
+
+TEST_MAIN()
@@ -0,0 +1,165 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const MAX_STEPS = 100000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Advances the fake clock by 1 ms per check() until the state is reached, the
+ * state machine has therefore just run when it returns.
+ */
+static bool runUntil(FakeConnectionHandler & handler, NetworkConnectionState const state)
+{
+  for (unsigned long i = 0; i < MAX_STEPS; i++)
+  {
+    advanceFakeMillis(1);
+    if (handler.check() == state)
+      return true;
+  }
+  return false;
+}
+
+static unsigned int handledCount(FakeConnectionHandler & handler)
+{
+  unsigned int count = 0;
+  for (unsigned int s = 0; s < NETWORK_CONNECTION_STATE_COUNT; s++)
+    count += handler.handled[s];
+  return count;
+}
+
+/* Right after the state machine has run, the deadline reported must be the
+ * interval of the current state: check() must not run the state machine one
+ * millisecond before it, and must run it exactly on it.
+ */
+static void requireDeadline(FakeConnectionHandler & handler)
+{
+  NetworkConnectionState const state = handler.currentState();
+  unsigned long const interval = handler.getCheckInterval(state);
+  unsigned long const due = handler.nextCheckDue();
+  REQUIRE_EQUAL(due, interval + 1);
+
+  unsigned int const handled_before = handledCount(handler);
+  advanceFakeMillis(due - 1);
+  handler.check();
+  REQUIRE_EQUAL(handledCount(handler), handled_before);
+  REQUIRE_EQUAL(handler.nextCheckDue(), 1);
+
+  advanceFakeMillis(1);
+  REQUIRE_EQUAL(handler.nextCheckDue(), 0);
+  handler.check();
+  bool const has_handler = (state != NetworkConnectionState::CLOSED && state != NetworkConnectionState::ERROR);
+  REQUIRE_EQUAL(handledCount(handler), handled_before + (has_handler ? 1 : 0));
+
+  /* The state machine has run, so the next deadline is a full interval away */
+  REQUIRE_EQUAL(handler.nextCheckDue(), handler.getCheckInterval(handler.currentState()) + 1);
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(deadline_in_init)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  REQUIRE(handler.currentState() == NetworkConnectionState::INIT);
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_connecting)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTING));
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_connected)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_disconnecting)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  handler.disconnect();
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_disconnected)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  handler.link_up = false;
+  REQUIRE(runUntil(handler, NetworkConnectionState::DISCONNECTED));
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_closed)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  handler.disconnect();
+  REQUIRE(runUntil(handler, NetworkConnectionState::CLOSED));
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_in_error)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.hardware_error = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::ERROR));
+  requireDeadline(handler);
+}
+
+TEST_CASE(deadline_follows_custom_intervals)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.setCheckInterval(NetworkConnectionState::CONNECTED, 60000);
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  REQUIRE_EQUAL(handler.nextCheckDue(), 60001);
+  requireDeadline(handler);
+}
+
+TEST_MAIN()
@@ -0,0 +1,217 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static int const ATTN_PIN = 5;
+static std::vector<uint8_t> const PAYLOAD = { 0xA1, 0x01, 0x02 };
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetNotecard()
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+  NotecardDevice.attn_pin = ATTN_PIN;
+}
+
+static bool bringUp(NotecardConnectionHandler & handler)
+{
+  handler.setAttnPin(ATTN_PIN);
+  maxCheckDuration(handler, 5000);
+  return handler.check() == NetworkConnectionState::CONNECTED;
+}
+
+/* Polls available() once per millisecond, as the CBOR read loop of a sketch
+ * does, and returns the number of Notes read.
+ */
+static unsigned int poll(NotecardConnectionHandler & handler, unsigned long const duration_ms)
+{
+  unsigned int notes = 0;
+  for (unsigned long i = 0; i < duration_ms; i++)
+  {
+    advanceFakeMillis(1);
+    if (handler.available())
+    {
+      uint8_t buf[64];
+      handler.read(buf, sizeof(buf));
+      notes++;
+    }
+  }
+  return notes;
+}
+
+/* note.get transactions per second issued while polling available() for 10 s,
+ * with a Note arriving every second.
+ */
+static double noteGetPerSecond(bool const en_hw_int, unsigned int & notes)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project", en_hw_int);
+  if (!bringUp(handler))
+    return -1.0;
+
+  unsigned long const note_get = NotecardDevice.requestCount("note.get");
+  unsigned long const transactions = NotecardDevice.transactions;
+  notes = 0;
+  for (unsigned int s = 0; s < 10; s++)
+  {
+    NotecardDevice.queueInbound(3, PAYLOAD);
+    notes += poll(handler, 1000);
+  }
+  printf("en_hw_int %d: %6.1f note.get/s, %6.1f transactions/s, %u Notes read\n", en_hw_int,
+         (NotecardDevice.requestCount("note.get") - note_get) / 10.0,
+         (NotecardDevice.transactions - transactions) / 10.0, notes);
+  return (NotecardDevice.requestCount("note.get") - note_get) / 10.0;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(transactions_per_second)
+{
+  unsigned int notes_polled = 0, notes_attn = 0;
+  double const polled = noteGetPerSecond(false, notes_polled);
+  double const attn = noteGetPerSecond(true, notes_attn);
+
+  REQUIRE_EQUAL(notes_polled, 10);
+  REQUIRE_EQUAL(notes_attn, 10);
+  /* One note.get per available() call while polling ... */
+  REQUIRE(polled >= 900.0);
+  /* ... and only the one popping the Note, the one finding the Notefile empty
+   * and the one after rearming ATTN
+   */
+  REQUIRE(attn <= 3.0);
+}
+
+TEST_CASE(bus_error_does_not_strand_notes)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project", true);
+  REQUIRE(bringUp(handler));
+  REQUIRE_EQUAL(poll(handler, 100), 0);
+  REQUIRE(NotecardDevice.attn_armed);
+
+  /* The Note is signalled, but the note.get reading it gets no response */
+  NotecardDevice.bus_errors = 1;
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 100), 1);
+  REQUIRE_EQUAL(NotecardDevice.inboundCount(), 0);
+}
+
+TEST_CASE(failed_request_does_not_strand_notes)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project", true);
+  REQUIRE(bringUp(handler));
+
+  NotecardDevice.allocation_errors = 1;
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 100), 1);
+}
+
+TEST_CASE(failed_rearm_keeps_polling)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project", true);
+  REQUIRE(bringUp(handler));
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 1), 1);
+
+  /* The Notefile is empty, but card.attn gets no response */
+  NotecardDevice.bus_errors = 1;
+  NotecardDevice.bus_error_request = "card.attn";
+  REQUIRE_EQUAL(poll(handler, 1), 0);
+  REQUIRE(!NotecardDevice.attn_armed);
+
+  /* ATTN is not armed, hence the Note is not signalled */
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 10), 1);
+  REQUIRE(NotecardDevice.attn_armed);
+}
+
+TEST_CASE(note_arriving_before_rearm_is_read)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  /* As the Notecard does, only signal the Notes arriving once rearmed */
+  NotecardDevice.attn_signals_pending = false;
+  NotecardConnectionHandler handler("com.example:project", true);
+  REQUIRE(bringUp(handler));
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 1), 1);
+
+  /* The Note arrives after the note.get finding the Notefile empty, but
+   * before card.attn is rearmed: it is read without waiting for another one
+   */
+  NotecardDevice.queueInboundAfter("note.get", 3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 10), 1);
+  REQUIRE_EQUAL(NotecardDevice.inboundCount(), 0);
+
+  /* And ATTN is armed for the next one */
+  REQUIRE_EQUAL(poll(handler, 10), 0);
+  REQUIRE(NotecardDevice.attn_armed);
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(handler, 1), 1);
+}
+
+TEST_CASE(attn_is_per_instance)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler first("com.example:project", true);
+  NotecardConnectionHandler second("com.example:project", true);
+  REQUIRE(bringUp(first));
+  REQUIRE(bringUp(second));
+  poll(first, 10);
+  poll(second, 10);
+
+  /* Only the first instance is bound to the interrupt, the second one polls */
+  unsigned long note_get = NotecardDevice.requestCount("note.get");
+  poll(first, 100);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("note.get"), note_get);
+  poll(second, 100);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("note.get"), note_get + 100);
+
+  /* Reading through the second instance does not clear the flag of the first */
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(second, 1), 1);
+  NotecardDevice.queueInbound(3, PAYLOAD);
+  REQUIRE_EQUAL(poll(first, 1), 1);
+}
+
+TEST_MAIN()
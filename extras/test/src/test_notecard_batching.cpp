@@ -0,0 +1,215 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static uint32_t const WINDOW_MS = 5000;
+static uint8_t const NOTE[40] = { 0 };
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetNotecard()
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+}
+
+static bool bringUp(NotecardConnectionHandler & handler)
+{
+  maxCheckDuration(handler, 5000);
+  return handler.check() == NetworkConnectionState::CONNECTED;
+}
+
+/* Polls available() once per millisecond, as the CBOR read loop of a sketch
+ * does, each call closing the batching window when due.
+ */
+static void poll(NotecardConnectionHandler & handler, unsigned long const duration_ms)
+{
+  for (unsigned long i = 0; i < duration_ms; i++)
+  {
+    advanceFakeMillis(1);
+    handler.available();
+  }
+}
+
+static unsigned long syncs()
+{
+  return NotecardDevice.requestCount("hub.sync");
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(window_closes_after_window_ms)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(WINDOW_MS);
+  REQUIRE(bringUp(handler));
+
+  /* The window opens with the first Note of the batch */
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    REQUIRE_EQUAL(handler.write(NOTE, sizeof(NOTE)), NotecardConnectionHandler::NOTECARD_ERROR_NONE);
+    poll(handler, 1000);
+  }
+  poll(handler, WINDOW_MS - 3000 - 1);
+  REQUIRE_EQUAL(syncs(), 0);
+  REQUIRE_EQUAL(NotecardDevice.outbound.size(), 3);
+
+  poll(handler, 1);
+  REQUIRE_EQUAL(syncs(), 1);
+  REQUIRE_EQUAL(handler.getSyncCount(), 1);
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 3);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), 3 * sizeof(NOTE));
+
+  /* Nothing is synced while the batch is empty */
+  poll(handler, 2 * WINDOW_MS);
+  REQUIRE_EQUAL(syncs(), 1);
+}
+
+TEST_CASE(byte_threshold_closes_the_window)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(60000, 100);
+  REQUIRE(bringUp(handler));
+
+  handler.write(NOTE, sizeof(NOTE));
+  handler.write(NOTE, sizeof(NOTE));
+  REQUIRE_EQUAL(syncs(), 0);
+
+  /* 120 bytes, synced right away */
+  handler.write(NOTE, sizeof(NOTE));
+  REQUIRE_EQUAL(syncs(), 1);
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 3);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), 3 * sizeof(NOTE));
+}
+
+TEST_CASE(high_priority_write_closes_the_window)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(WINDOW_MS);
+  REQUIRE(bringUp(handler));
+
+  handler.write(NOTE, sizeof(NOTE));
+  poll(handler, 100);
+  REQUIRE_EQUAL(syncs(), 0);
+
+  /* Synced together with the Note already batched */
+  handler.write(NOTE, 10, true);
+  REQUIRE_EQUAL(syncs(), 1);
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 2);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), sizeof(NOTE) + 10);
+
+  /* The next Note opens a new window */
+  handler.write(NOTE, sizeof(NOTE));
+  poll(handler, WINDOW_MS - 1);
+  REQUIRE_EQUAL(syncs(), 1);
+  poll(handler, 1);
+  REQUIRE_EQUAL(syncs(), 2);
+}
+
+TEST_CASE(failed_sync_is_retried_after_a_window)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(WINDOW_MS);
+  REQUIRE(bringUp(handler));
+
+  /* The hub.sync closing the window gets no response */
+  NotecardDevice.bus_errors = 1;
+  NotecardDevice.bus_error_request = "hub.sync";
+  handler.write(NOTE, sizeof(NOTE));
+  poll(handler, WINDOW_MS);
+  REQUIRE_EQUAL(syncs(), 1);
+  REQUIRE_EQUAL(handler.getSyncCount(), 0);
+
+  /* Not retried on every call, but once the next window has elapsed,
+   * together with the Notes batched in the meantime
+   */
+  handler.write(NOTE, sizeof(NOTE));
+  poll(handler, WINDOW_MS - 1);
+  REQUIRE_EQUAL(syncs(), 1);
+  poll(handler, 1);
+  REQUIRE_EQUAL(syncs(), 2);
+  REQUIRE_EQUAL(handler.getSyncCount(), 1);
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 2);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), 2 * sizeof(NOTE));
+}
+
+TEST_CASE(counters_average_over_syncs)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(WINDOW_MS);
+  REQUIRE(bringUp(handler));
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 0);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), 0);
+
+  /* 2 Notes of 40 bytes, then 4 Notes of 10 bytes */
+  handler.write(NOTE, sizeof(NOTE));
+  handler.write(NOTE, sizeof(NOTE));
+  poll(handler, WINDOW_MS);
+  for (unsigned int i = 0; i < 4; i++)
+    handler.write(NOTE, 10);
+  poll(handler, WINDOW_MS);
+
+  REQUIRE_EQUAL(handler.getSyncCount(), 2);
+  REQUIRE_EQUAL(handler.getNotesPerSync(), 3);
+  REQUIRE_EQUAL(handler.getBytesPerSync(), 60);
+}
+
+TEST_CASE(no_batching_syncs_every_note)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  REQUIRE(bringUp(handler));
+
+  /* Each note.add requests its own sync, no hub.sync is sent */
+  handler.write(NOTE, sizeof(NOTE));
+  handler.write(NOTE, sizeof(NOTE), true);
+  poll(handler, 2 * WINDOW_MS);
+  REQUIRE_EQUAL(NotecardDevice.outbound.size(), 2);
+  REQUIRE_EQUAL(syncs(), 0);
+  REQUIRE_EQUAL(handler.getSyncCount(), 0);
+}
+
+TEST_MAIN()
@@ -0,0 +1,137 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const TRANSACTION_MS = 25;
+/* At most two Notecard transactions per check() */
+static unsigned long const CHECK_BUDGET_MS = 2 * TRANSACTION_MS;
+static int const ATTN_PIN = 5;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetNotecard(bool const connected)
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transaction_ms = TRANSACTION_MS;
+  NotecardDevice.transport_connected = connected;
+  NotecardDevice.connected_to_notehub = connected;
+  NotecardDevice.attn_pin = ATTN_PIN;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(bring_up_within_budget)
+{
+  bool const EN_HW_INT[] = { false, true };
+  for (bool const en_hw_int : EN_HW_INT)
+  {
+    setFakeMillis(1000);
+    resetNotecard(true);
+    NotecardConnectionHandler handler("com.example:project", en_hw_int);
+    handler.setAttnPin(ATTN_PIN);
+
+    CheckDuration const duration = maxCheckDuration(handler, 10000);
+    printf("en_hw_int %d: %lu transactions, longest check() %lu ms (budget %lu ms)\n",
+           en_hw_int, NotecardDevice.transactions, duration.max_blocking_ms, CHECK_BUDGET_MS);
+    REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+    REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+  }
+}
+
+TEST_CASE(rejected_hub_set_is_retried_on_later_checks)
+{
+  setFakeMillis(1000);
+  resetNotecard(true);
+  NotecardDevice.hub_set_errors = 20;
+  NotecardConnectionHandler handler("com.example:project");
+
+  CheckDuration const duration = maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("hub.set"), 21);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+}
+
+TEST_CASE(connecting_and_reconnecting_within_budget)
+{
+  setFakeMillis(1000);
+  resetNotecard(false);
+  NotecardConnectionHandler handler("com.example:project");
+  handler.setSyncBatching(5000);
+
+  /* Waiting for Notehub only polls hub.status */
+  CheckDuration duration = maxCheckDuration(handler, 60000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+  duration = maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+
+  /* A batch is synced from check(), together with the status poll */
+  uint8_t const data[] = { 1, 2, 3 };
+  handler.write(data, sizeof(data));
+  duration = maxCheckDuration(handler, 20000);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("hub.sync"), 1);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+
+  /* The configuration acknowledged before is not sent again */
+  unsigned long const hub_set = NotecardDevice.requestCount("hub.set");
+  NotecardDevice.connected_to_notehub = false;
+  duration = maxCheckDuration(handler, 20000);
+  NotecardDevice.connected_to_notehub = true;
+  duration = maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("hub.set"), hub_set);
+  REQUIRE(handler.getSavedTransactions() >= 4);
+}
+
+TEST_CASE(closing_within_budget)
+{
+  setFakeMillis(1000);
+  resetNotecard(true);
+  NotecardConnectionHandler handler("com.example:project");
+  maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  NotecardDevice.hub_set_errors = 5;
+  handler.disconnect();
+  CheckDuration const duration = maxCheckDuration(handler, 10000);
+  REQUIRE(handler.check() == NetworkConnectionState::CLOSED);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+}
+
+TEST_MAIN()
@@ -0,0 +1,151 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/* Built with and without BOARD_HAS_SECRET_KEY, i.e. with and without the
+ * environment variable template step.
+ */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned int const INIT = static_cast<unsigned int>(NetworkConnectionState::INIT);
+static unsigned long const INIT_INTERVAL_MS = DEFAULT_CHECK_INTERVAL_TABLE[NetworkConnectionState::INIT];
+
+#if defined(BOARD_HAS_SECRET_KEY)
+static unsigned int const TEMPLATES = 3;
+#else
+static unsigned int const TEMPLATES = 2;
+#endif
+
+/* BEGIN, HUB_SET, the templates and DEVICE_UID, one check() each */
+static unsigned int const CONFIGURATION_CHECKS = 3 + TEMPLATES;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetNotecard()
+{
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+}
+
+static unsigned long configurationRequests()
+{
+  return NotecardDevice.requestCount("hub.set")
+       + NotecardDevice.requestCount("env.template")
+       + NotecardDevice.requestCount("note.template")
+       + NotecardDevice.requestCount("hub.get");
+}
+
+/* Connects (again), and returns the number of check() calls spent in INIT */
+static unsigned long connect(NotecardConnectionHandler & handler)
+{
+  unsigned long const init_ms = handler.getMetrics().dwell_ms[INIT];
+  maxCheckDuration(handler, 5000);
+  if (handler.check() != NetworkConnectionState::CONNECTED)
+    return 0;
+  return (handler.getMetrics().dwell_ms[INIT] - init_ms) / INIT_INTERVAL_MS;
+}
+
+/* Loses the connection to Notehub and waits for the handler to notice */
+static void loseConnection(NotecardConnectionHandler & handler)
+{
+  NotecardDevice.connected_to_notehub = false;
+  while (handler.check() == NetworkConnectionState::CONNECTED)
+    advanceFakeMillis(1);
+  NotecardDevice.connected_to_notehub = true;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(reconnect_skips_configured_steps)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+
+  /* The whole configuration, one request per check() */
+  REQUIRE_EQUAL(connect(handler), CONFIGURATION_CHECKS);
+  REQUIRE_EQUAL(configurationRequests(), 2 + TEMPLATES);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("env.template"), TEMPLATES - 2);
+  REQUIRE_EQUAL(handler.getSavedTransactions(), 0);
+
+  /* On reconnection, only BEGIN and DEVICE_UID (from the cache) remain */
+  for (unsigned int reconnection = 1; reconnection <= 3; reconnection++)
+  {
+    loseConnection(handler);
+    REQUIRE_EQUAL(connect(handler), 2);
+    REQUIRE_EQUAL(configurationRequests(), 2 + TEMPLATES);
+    REQUIRE_EQUAL(handler.getSavedTransactions(), reconnection * (2 + TEMPLATES));
+  }
+}
+
+TEST_CASE(invalidated_configuration_is_sent_again)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  REQUIRE_EQUAL(connect(handler), CONFIGURATION_CHECKS);
+
+  loseConnection(handler);
+  handler.invalidateConfiguration();
+  REQUIRE_EQUAL(connect(handler), CONFIGURATION_CHECKS);
+  REQUIRE_EQUAL(configurationRequests(), 2 * (2 + TEMPLATES));
+  REQUIRE_EQUAL(handler.getSavedTransactions(), 0);
+
+  /* And is skipped again afterwards */
+  loseConnection(handler);
+  REQUIRE_EQUAL(connect(handler), 2);
+  REQUIRE_EQUAL(configurationRequests(), 2 * (2 + TEMPLATES));
+}
+
+TEST_CASE(closed_connection_sends_hub_set_again)
+{
+  setFakeMillis(1000);
+  resetNotecard();
+  NotecardConnectionHandler handler("com.example:project");
+  REQUIRE_EQUAL(connect(handler), CONFIGURATION_CHECKS);
+
+  /* Closing the connection overrides the hub.set of the configuration */
+  handler.disconnect();
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CLOSED);
+  unsigned long const hub_set = NotecardDevice.requestCount("hub.set");
+
+  handler.connect();
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("hub.set"), hub_set + 1);
+  REQUIRE_EQUAL(NotecardDevice.requestCount("note.template"), 2);
+}
+
+TEST_MAIN()
@@ -0,0 +1,120 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+#include <malloc.h>
+
+#include <random>
+#include <type_traits>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* The handler owns its inbound buffer */
+static_assert(!std::is_copy_constructible<NotecardConnectionHandler>::value, "NotecardConnectionHandler must not be copyable");
+static_assert(!std::is_copy_assignable<NotecardConnectionHandler>::value, "NotecardConnectionHandler must not be copy assignable");
+
+static unsigned int const NOTE_COUNT = 10000;
+static unsigned int const WARM_UP_NOTES = 100;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  #define HAS_HEAP_STATISTICS 1
+
+struct HeapUsage
+{
+  size_t in_use; /* Bytes allocated */
+  size_t arena;  /* Bytes obtained from the system, grows with fragmentation */
+};
+
+static HeapUsage heapUsage()
+{
+  struct mallinfo2 const info = mallinfo2();
+  return HeapUsage{info.uordblks, info.arena};
+}
+#endif
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(heap_high_water_over_10k_notes)
+{
+#if defined(HAS_HEAP_STATISTICS)
+  setFakeMillis(1000);
+  NotecardDevice = NotecardSimulation();
+  NotecardDevice.transport_connected = true;
+  NotecardDevice.connected_to_notehub = true;
+
+  NotecardConnectionHandler handler("com.example:project");
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  std::mt19937 random(42);
+  std::uniform_int_distribution<size_t> note_size(1, NotecardConnectionHandler::DEFAULT_INBOUND_BUFFER_CAPACITY - 4);
+  HeapUsage warm = { 0, 0 };
+  HeapUsage high_water = { 0, 0 };
+  unsigned long bytes_read = 0;
+
+  for (unsigned int n = 0; n < NOTE_COUNT; n++)
+  {
+    /* A single larger Note grows the buffer once, during the warm up */
+    std::vector<uint8_t> payload((n == WARM_UP_NOTES / 2) ? 1024 : note_size(random));
+    for (uint8_t & b : payload) b = random();
+    NotecardDevice.queueInbound(3, payload);
+    payload = std::vector<uint8_t>();
+
+    REQUIRE(handler.available());
+    uint8_t buf[64];
+    for (int len; (len = handler.read(buf, sizeof(buf))) > 0; )
+      bytes_read += len;
+    REQUIRE(!handler.available());
+
+    /* Only the allocations which outlive a Note are left at this point */
+    HeapUsage const usage = heapUsage();
+    if (n == WARM_UP_NOTES) warm = usage;
+    if (usage.in_use > high_water.in_use) high_water.in_use = usage.in_use;
+    if (usage.arena > high_water.arena) high_water.arena = usage.arena;
+    if (n >= WARM_UP_NOTES)
+    {
+      REQUIRE_EQUAL(usage.in_use, warm.in_use);
+      REQUIRE(usage.arena <= warm.arena);
+    }
+  }
+
+  printf("%u Notes, %lu bytes: heap in use %zu bytes (high water %zu), arena %zu bytes (high water %zu)\n",
+         NOTE_COUNT, bytes_read, warm.in_use, high_water.in_use, warm.arena, high_water.arena);
+  REQUIRE_EQUAL(NotecardDevice.inboundCount(), 0);
+#else
+  printf("heap statistics not available, skipped\n");
+#endif
+}
+
+TEST_MAIN()
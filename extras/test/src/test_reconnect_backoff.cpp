@@ -0,0 +1,196 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+
+#include <set>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const MAX_STEPS = 1000000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Advances the fake clock by 1 ms per check() until a new connection attempt
+ * has been started, and returns the time it took (0 if none was started).
+ */
+static unsigned long runUntilNextAttempt(FakeConnectionHandler & handler)
+{
+  unsigned int const attempts = handler.attempts;
+  for (unsigned long i = 1; i <= MAX_STEPS; i++)
+  {
+    advanceFakeMillis(1);
+    handler.check();
+    if (handler.attempts != attempts)
+      return i;
+  }
+  return 0;
+}
+
+static bool runUntil(FakeConnectionHandler & handler, NetworkConnectionState const state)
+{
+  for (unsigned long i = 0; i < MAX_STEPS; i++)
+  {
+    advanceFakeMillis(1);
+    if (handler.check() == state)
+      return true;
+  }
+  return false;
+}
+
+static unsigned int connectingCount(FakeConnectionHandler & handler)
+{
+  return handler.handled[static_cast<unsigned int>(NetworkConnectionState::CONNECTING)];
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(retry_schedule)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.enableReconnectBackoff(1000, 8000, 2, 0);
+
+  /* INIT then the first CONNECTING check, at the default intervals */
+  REQUIRE_EQUAL(runUntilNextAttempt(handler), 101 + 501);
+
+  /* Each failed attempt doubles the delay before the next one, up to max_ms */
+  unsigned long const EXPECTED_SPACING[] = { 1001, 2001, 4001, 8001, 8001, 8001 };
+  for (unsigned long const spacing : EXPECTED_SPACING)
+    REQUIRE_EQUAL(runUntilNextAttempt(handler), spacing);
+
+  /* Once connected the schedule starts over */
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  handler.link_up = false;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTING));
+  handler.disableReconnectBackoff();
+  handler.enableReconnectBackoff(1000, 8000, 2, 0);
+  runUntilNextAttempt(handler);
+  REQUIRE_EQUAL(runUntilNextAttempt(handler), 1001);
+}
+
+TEST_CASE(attempt_in_progress_is_polled_at_connecting_interval)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.attempt_duration_ms = 3000;
+  handler.enableReconnectBackoff(60000, 60000, 2, 0);
+
+  /* The attempt started by the first CONNECTING check is polled every 501 ms
+   * until it times out, without any backoff delay.
+   */
+  REQUIRE(runUntilNextAttempt(handler) > 0);
+  unsigned int const polls_before = connectingCount(handler);
+  for (unsigned int i = 0; i < 5; i++)
+  {
+    REQUIRE_EQUAL(handler.nextCheckDue(), 501);
+    advanceFakeMillis(501);
+    handler.check();
+  }
+  REQUIRE_EQUAL(connectingCount(handler), polls_before + 5);
+
+  /* The poll exceeding attempt_duration_ms fails the attempt, only then is
+   * the next one delayed.
+   */
+  advanceFakeMillis(501);
+  handler.check();
+  REQUIRE_EQUAL(handler.attempts, 1);
+  REQUIRE_EQUAL(handler.nextCheckDue(), 60001);
+
+  /* And the attempt is completed as soon as the link comes up */
+  REQUIRE_EQUAL(runUntilNextAttempt(handler), 60001);
+  handler.link_up = true;
+  advanceFakeMillis(501);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(connection_loss_delays_reconnection)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  handler.enableReconnectBackoff(4000, 32000, 2, 0);
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+
+  handler.link_up = false;
+  REQUIRE(runUntil(handler, NetworkConnectionState::DISCONNECTED));
+  REQUIRE_EQUAL(handler.nextCheckDue(), 4001);
+
+  /* The backoff delay only postpones the first check after the loss */
+  advanceFakeMillis(4001);
+  REQUIRE(handler.check() == NetworkConnectionState::INIT);
+  REQUIRE_EQUAL(handler.nextCheckDue(), 101);
+
+  /* A user requested disconnect() is never delayed */
+  handler.link_up = true;
+  REQUIRE(runUntil(handler, NetworkConnectionState::CONNECTED));
+  handler.disconnect();
+  REQUIRE_EQUAL(handler.nextCheckDue(), 101);
+}
+
+TEST_CASE(jitter_spreads_retries)
+{
+  setFakeMillis(1000);
+  std::set<unsigned long> delays;
+
+  for (uint32_t seed = 1; seed <= 1000; seed++)
+  {
+    FakeConnectionHandler handler;
+    handler.enableReconnectBackoff(1000, 8000, 2, 50, seed);
+    REQUIRE(runUntilNextAttempt(handler) > 0);
+
+    /* At most 50 % shorter than the nominal 1000 ms delay */
+    unsigned long const delay = handler.nextCheckDue() - 1;
+    REQUIRE(delay >= 500 && delay <= 1000);
+    delays.insert(delay);
+  }
+
+  /* A fleet reconnecting at once does not retry in lockstep */
+  REQUIRE(delays.size() > 300);
+  printf("1000 seeds: %zu distinct first retry delays in [%lu, %lu] ms\n", delays.size(), *delays.begin(), *delays.rbegin());
+}
+
+TEST_CASE(same_seed_same_schedule)
+{
+  unsigned long schedule[2][8];
+  for (unsigned int run = 0; run < 2; run++)
+  {
+    setFakeMillis(1000);
+    FakeConnectionHandler handler;
+    handler.enableReconnectBackoff(1000, 8000, 2, 50, 0x1234);
+    for (unsigned int i = 0; i < 8; i++)
+      schedule[run][i] = runUntilNextAttempt(handler);
+  }
+
+  for (unsigned int i = 0; i < 8; i++)
+    REQUIRE_EQUAL(schedule[1][i], schedule[0][i]);
+}
+
+TEST_MAIN()
@@ -0,0 +1,141 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const EPOCH = 1700000000UL;
+static uint32_t const CACHE_INTERVAL_MS = 60000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/* Reads getTime() every 100 ms over duration_ms, like an application
+ * timestamping its samples, and returns the largest error (in seconds)
+ * against the source.
+ */
+static long timestampSamples(FakeConnectionHandler & handler, unsigned long const duration_ms)
+{
+  long max_error = 0;
+  for (unsigned long t = 0; t < duration_ms; t += 100)
+  {
+    long const error = static_cast<long>(handler.getTime()) - static_cast<long>(handler.sourceTime());
+    if (labs(error) > labs(max_error))
+      max_error = error;
+    advanceFakeMillis(100);
+  }
+  return max_error;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(cache_reduces_source_reads)
+{
+  setFakeMillis(0);
+  FakeConnectionHandler handler;
+  handler.time_epoch = EPOCH;
+  handler.time_drift_ppm = 100;
+
+  /* Without the cache, every call reads the source */
+  REQUIRE_EQUAL(timestampSamples(handler, 60000), 0);
+  REQUIRE_EQUAL(handler.time_reads, 600);
+
+  /* With it, one read per interval, the extrapolation staying within a second */
+  handler.time_reads = 0;
+  handler.setTimeCacheInterval(CACHE_INTERVAL_MS);
+  long const max_error = timestampSamples(handler, 3600000);
+  printf("1 h of samples every 100 ms: %u source reads (36000 uncached), largest error %ld s\n",
+         handler.time_reads, max_error);
+  REQUIRE_EQUAL(handler.time_reads, 3600000 / CACHE_INTERVAL_MS);
+  REQUIRE(labs(max_error) <= 1);
+}
+
+TEST_CASE(drift_estimate_accuracy)
+{
+  long const DRIFT_PPM[] = { 0, 20, -20, 150, -500, 5000 };
+  for (long const drift : DRIFT_PPM)
+  {
+    setFakeMillis(123);
+    FakeConnectionHandler handler;
+    handler.time_epoch = EPOCH;
+    handler.time_drift_ppm = drift;
+    handler.setTimeCacheInterval(CACHE_INTERVAL_MS);
+
+    /* No estimate from readings a minute apart, dominated by the resolution */
+    timestampSamples(handler, 3000000);
+    REQUIRE_EQUAL(handler.getTimeDrift(), 0);
+
+    timestampSamples(handler, 3600000);
+    long const after_hour = handler.getTimeDrift();
+    for (int h = 0; h < 23; h++)
+      timestampSamples(handler, 3600000);
+    long const after_day = handler.getTimeDrift();
+    printf("drift %5ld ppm: estimate %5ld ppm after 1 h, %5ld ppm after 24 h\n", drift, after_hour, after_day);
+    REQUIRE(labs(after_hour - drift) <= 278);
+    REQUIRE(labs(after_day - drift) <= 12);
+  }
+}
+
+TEST_CASE(time_step_restarts_the_estimate)
+{
+  setFakeMillis(0);
+  FakeConnectionHandler handler;
+  handler.time_epoch = EPOCH;
+  handler.time_drift_ppm = 100;
+  handler.setTimeCacheInterval(CACHE_INTERVAL_MS);
+  timestampSamples(handler, 2 * 3600000);
+  REQUIRE(labs(handler.getTimeDrift() - 100) <= 139);
+
+  /* The source is set one day ahead: the estimate is kept, not skewed */
+  handler.time_epoch += 86400;
+  timestampSamples(handler, 3600000);
+  REQUIRE(labs(handler.getTimeDrift() - 100) <= 139);
+  timestampSamples(handler, 24 * 3600000UL);
+  REQUIRE(labs(handler.getTimeDrift() - 100) <= 12);
+}
+
+TEST_CASE(millis_rollover)
+{
+  /* Starting 10 minutes before millis() wraps around on the target */
+  setFakeMillis(0xFFFFFFFFUL - 600000);
+  FakeConnectionHandler handler;
+  handler.time_epoch = EPOCH;
+  handler.time_drift_ppm = -50;
+  handler.setTimeCacheInterval(CACHE_INTERVAL_MS);
+
+  REQUIRE(labs(timestampSamples(handler, 2 * 3600000)) <= 1);
+  REQUIRE(labs(handler.getTimeDrift() + 50) <= 139);
+
+  /* A baseline of more than 24.8 days is restarted before it overflows */
+  for (int d = 0; d < 30; d++)
+    timestampSamples(handler, 24 * 3600000UL);
+  REQUIRE(labs(handler.getTimeDrift() + 50) <= 12);
+}
+
+TEST_MAIN()
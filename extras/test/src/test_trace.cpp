@@ -0,0 +1,187 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "FakeConnectionHandler.h"
+
+#include <string>
+#include <cstring>
+
+/* Built with CONNECTION_HANDLER_TRACE_SIZE 4. The trace printed by
+ * dump_format is decoded by extras/tools/decode_trace.py in the
+ * test_trace_decode test.
+ */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static_assert(CONNECTION_HANDLER_TRACE_SIZE == 4, "test_trace expects a trace of 4 entries");
+
+static uint8_t const INIT_TO_CONNECTING          = 0x01;
+static uint8_t const CONNECTING_TO_CONNECTED     = 0x12;
+static uint8_t const CONNECTED_TO_DISCONNECTED   = 0x24;
+static uint8_t const DISCONNECTED_TO_INIT        = 0x40;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+class StringPrint : public Print
+{
+  public:
+    std::string str;
+    virtual size_t write(uint8_t c) override { str += static_cast<char>(c); return 1; }
+    using Print::write;
+};
+
+class StdoutPrint : public Print
+{
+  public:
+    virtual size_t write(uint8_t c) override { return (fputc(c, stdout) != EOF) ? 1 : 0; }
+    using Print::write;
+};
+
+static void runUntil(FakeConnectionHandler & handler, NetworkConnectionState const state, unsigned long const duration_ms)
+{
+  for (unsigned long t = 0; t < duration_ms && handler.check() != state; t++)
+    advanceFakeMillis(1);
+}
+
+/* Brings the handler up, loses the link and reconnects: 6 transitions */
+static void connectTwice(FakeConnectionHandler & handler)
+{
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+  advanceFakeMillis(60000);
+  handler.link_up = false;
+  runUntil(handler, NetworkConnectionState::DISCONNECTED, 10000);
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+}
+
+static std::string hex(uint32_t const value, unsigned int const bytes)
+{
+  static char const HEX_DIGITS[] = "0123456789ABCDEF";
+  std::string str;
+  for (unsigned int i = 0; i < bytes; i++)
+  {
+    uint8_t const b = (value >> (8 * i)) & 0xFF;
+    str += HEX_DIGITS[b >> 4];
+    str += HEX_DIGITS[b & 0x0F];
+  }
+  return str;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(entry_layout)
+{
+  REQUIRE_EQUAL(sizeof(TransitionTraceEntry), 6);
+
+  setFakeMillis(0x01020304);
+  FakeConnectionHandler handler;
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTING, 1000);
+
+  TransitionTraceEntry entry;
+  REQUIRE_EQUAL(handler.getTrace(&entry, 1), 1);
+  uint8_t raw[sizeof(entry)];
+  memcpy(raw, &entry, sizeof(entry));
+
+  /* Little endian timestamp, previous state in the high nibble, reason */
+  REQUIRE_EQUAL(raw[0] | (raw[1] << 8) | (raw[2] << 16) | (static_cast<uint32_t>(raw[3]) << 24), entry.timestamp_ms);
+  REQUIRE_EQUAL(raw[3], 0x01);
+  REQUIRE_EQUAL(raw[2], 0x02);
+  REQUIRE_EQUAL(raw[4], INIT_TO_CONNECTING);
+  REQUIRE_EQUAL(raw[5], static_cast<uint8_t>(TransitionReason::NONE));
+}
+
+TEST_CASE(wrap_around_keeps_the_latest_in_order)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler;
+  TransitionTraceEntry entries[8];
+
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+  REQUIRE_EQUAL(handler.getTrace(entries, 8), 2);
+  REQUIRE_EQUAL(entries[0].states, INIT_TO_CONNECTING);
+  REQUIRE_EQUAL(entries[1].states, CONNECTING_TO_CONNECTED);
+
+  /* 4 more transitions: the first 2 are overwritten, oldest first */
+  advanceFakeMillis(60000);
+  handler.link_up = false;
+  runUntil(handler, NetworkConnectionState::DISCONNECTED, 10000);
+  handler.link_up = true;
+  runUntil(handler, NetworkConnectionState::CONNECTED, 10000);
+  REQUIRE_EQUAL(handler.getMetrics().entries[static_cast<unsigned int>(NetworkConnectionState::CONNECTED)], 2);
+
+  REQUIRE_EQUAL(handler.getTrace(entries, 8), 4);
+  REQUIRE_EQUAL(entries[0].states, CONNECTED_TO_DISCONNECTED);
+  REQUIRE_EQUAL(entries[0].reason, static_cast<uint8_t>(TransitionReason::CONNECTION_LOST));
+  REQUIRE_EQUAL(entries[1].states, DISCONNECTED_TO_INIT);
+  REQUIRE_EQUAL(entries[2].states, INIT_TO_CONNECTING);
+  REQUIRE_EQUAL(entries[3].states, CONNECTING_TO_CONNECTED);
+  REQUIRE_EQUAL(entries[3].reason, static_cast<uint8_t>(TransitionReason::NONE));
+  for (unsigned int i = 1; i < 4; i++)
+    REQUIRE(entries[i].timestamp_ms >= entries[i - 1].timestamp_ms);
+  REQUIRE(entries[0].timestamp_ms >= 61000);
+
+  /* A smaller buffer gets the oldest entries */
+  REQUIRE_EQUAL(handler.getTrace(entries, 2), 2);
+  REQUIRE_EQUAL(entries[0].states, CONNECTED_TO_DISCONNECTED);
+  REQUIRE_EQUAL(entries[1].states, DISCONNECTED_TO_INIT);
+}
+
+TEST_CASE(dump_format)
+{
+  setFakeMillis(1000);
+  FakeConnectionHandler handler(true, NetworkAdapter::GSM);
+
+  /* An empty trace is a header only */
+  StringPrint empty;
+  handler.dumpTrace(empty);
+  REQUIRE(empty.str == "CHTRACE:01030000\n");
+
+  connectTwice(handler);
+  TransitionTraceEntry entries[4];
+  REQUIRE_EQUAL(handler.getTrace(entries, 4), 4);
+
+  /* Version 1, adapter, little endian count, then the entries oldest first */
+  std::string expected = "CHTRACE:01030400";
+  for (TransitionTraceEntry const & entry : entries)
+    expected += hex(entry.timestamp_ms, 4) + hex(entry.states, 1) + hex(entry.reason, 1);
+  expected += "\n";
+
+  StringPrint dump;
+  handler.dumpTrace(dump);
+  REQUIRE(dump.str == expected);
+
+  /* For test_trace_decode */
+  StdoutPrint out;
+  handler.dumpTrace(out);
+  fflush(stdout);
+}
+
+TEST_MAIN()
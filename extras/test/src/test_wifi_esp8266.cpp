@@ -0,0 +1,102 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "test.h"
+#include "CheckDuration.h"
+
+#include <Arduino_ConnectionHandler.h>
+
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* check() must never block the sketch for longer than this */
+static unsigned long const CHECK_BUDGET_MS = 5;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+static void resetWiFi(unsigned long const association_ms, bool const access_point_up)
+{
+  WiFi = WiFiClass();
+  WiFi.association_ms = association_ms;
+  WiFi.access_point_up = access_point_up;
+}
+
+/******************************************************************************
+   TEST CASES
+ ******************************************************************************/
+
+TEST_CASE(connect_does_not_block)
+{
+  setFakeMillis(1000);
+  resetWiFi(2500, true);
+  WiFiConnectionHandler handler("ssid", "pass");
+
+  CheckDuration const duration = maxCheckDuration(handler, 10000);
+  printf("association in 2500 ms: %lu calls, longest check() %lu ms simulated, %.1f us wall\n",
+         duration.calls, duration.max_blocking_ms, duration.max_wall_us);
+
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+  REQUIRE_EQUAL(WiFi.begin_calls, 1);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+}
+
+TEST_CASE(timeout_does_not_block)
+{
+  setFakeMillis(1000);
+  resetWiFi(0, false);
+  WiFiConnectionHandler handler("ssid", "pass");
+
+  CheckDuration const duration = maxCheckDuration(handler, 30000);
+  printf("no access point: %u attempts in 30 s, longest check() %lu ms simulated, %.1f us wall\n",
+         WiFi.begin_calls, duration.max_blocking_ms, duration.max_wall_us);
+
+  /* An attempt times out after 3 s, then the next one starts on the
+   * following CONNECTING check.
+   */
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE(WiFi.begin_calls >= 7);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+
+  /* And it still connects once the access point is back */
+  WiFi.access_point_up = true;
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+}
+
+TEST_CASE(connection_loss_does_not_block)
+{
+  setFakeMillis(1000);
+  resetWiFi(500, true);
+  WiFiConnectionHandler handler("ssid", "pass");
+  maxCheckDuration(handler, 5000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTED);
+
+  WiFi.access_point_up = false;
+  CheckDuration const duration = maxCheckDuration(handler, 20000);
+  REQUIRE(handler.check() == NetworkConnectionState::CONNECTING);
+  REQUIRE(duration.max_blocking_ms <= CHECK_BUDGET_MS);
+}
+
+TEST_MAIN()
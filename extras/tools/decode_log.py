@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Arduino_ConnectionHandler library.
+#
+# Decodes the binary log written by the tokenized logging backend (library
+# built with CONNECTION_HANDLER_LOG_TOKENIZED). The tokens are mapped back to
+# the messages by hashing the format strings of the CH_LOG_xxx() calls found
+# in the library sources, which must match the version running on the board.
+#
+# Usage: decode_log.py [-s path/to/library/src] capture.bin
+
+import argparse
+import codecs
+import glob
+import os
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER = struct.Struct("<BBBI")
+
+LEVELS = {0: "ERROR", 1: "WARNING", 2: "INFO", 3: "DEBUG", 4: "VERBOSE"}
+
+LOG_CALL = re.compile(r'CH_LOG_[A-Z]+\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"')
+CONVERSION = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXcs%])')
+LENGTH_MODIFIER = re.compile(r'(?:hh|h|ll|l|z)(?=[diuxXcs]$)')
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def load_messages(src_dir):
+    messages = {}
+    for path in glob.glob(os.path.join(src_dir, "*.cpp")):
+        with open(path) as f:
+            for call in LOG_CALL.finditer(f.read()):
+                fmt = "".join(codecs.decode(lit, "unicode_escape") for lit in LITERAL.findall(call.group(1)))
+                token = fnv1a(fmt.encode("latin-1"))
+                if token in messages and messages[token] != fmt:
+                    print("warning: token collision 0x{:08X}".format(token), file=sys.stderr)
+                messages[token] = fmt
+    return messages
+
+
+def format_message(fmt, payload):
+    # The arguments which did not fit in the frame (64 bytes at most) are
+    # missing from the end of the payload
+    args = []
+    pos = 0
+    for conv in CONVERSION.findall(fmt):
+        if conv == "%":
+            continue
+        if conv == "s":
+            if pos >= len(payload) or pos + 1 + payload[pos] > len(payload):
+                break
+            length = payload[pos]
+            args.append(payload[pos + 1:pos + 1 + length].decode("latin-1"))
+            pos += 1 + length
+        else:
+            if pos + 4 > len(payload):
+                break
+            (value,) = struct.unpack_from("<i" if conv in "di" else "<I", payload, pos)
+            args.append(value)
+            pos += 4
+
+    def convert(match):
+        if match.group(1) == "%":
+            return "%"
+        if not args:
+            return "<truncated>"
+        # Python's % operator does not know the C length modifiers
+        return LENGTH_MODIFIER.sub("", match.group(0)) % args.pop(0)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def main():
+    default_src = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "src")
+    parser = argparse.ArgumentParser(description="Decode a tokenized Arduino_ConnectionHandler log")
+    parser.add_argument("-s", "--src", default=default_src, help="library src directory")
+    parser.add_argument("capture", help="binary capture of the log output")
+    args = parser.parse_args()
+
+    messages = load_messages(args.src)
+    with open(args.capture, "rb") as f:
+        data = f.read()
+
+    pos = 0
+    while pos + FRAME_HEADER.size <= len(data):
+        sync, level, size, token = FRAME_HEADER.unpack_from(data, pos)
+        end = pos + FRAME_HEADER.size + size
+        # Resynchronize on anything which is not a known frame (e.g. text output)
+        if sync != FRAME_SYNC or token not in messages or end > len(data):
+            pos += 1
+            continue
+        payload = data[pos + FRAME_HEADER.size:end]
+        print("[{}] {}".format(LEVELS.get(level, level), format_message(messages[token], payload)))
+        pos = end
+
+
+if __name__ == "__main__":
+    main()
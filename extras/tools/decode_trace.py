@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Arduino_ConnectionHandler library.
+#
+# Decodes the transition trace printed by ConnectionHandler::dumpTrace()
+# (library built with CONNECTION_HANDLER_TRACE_SIZE > 0). Reads a serial log
+# from the given file, or from stdin, and decodes every "CHTRACE:" line in it.
+#
+# Usage: decode_trace.py [serial.log]
+
+import struct
+import sys
+
+MARKER = "CHTRACE:"
+FORMAT_VERSION = 1
+ENTRY = struct.Struct("<IBB")
+
+ADAPTERS = ["WIFI", "ETHERNET", "NB", "GSM", "LORA", "CATM1", "NOTECARD"]
+STATES = ["INIT", "CONNECTING", "CONNECTED", "DISCONNECTING", "DISCONNECTED", "CLOSED", "ERROR"]
+REASONS = ["", "USER_REQUEST", "HARDWARE_ERROR", "TIMEOUT", "AUTH_FAILED",
+           "ATTACH_FAILED", "CONNECTION_LOST", "CONFIG_FAILED"]
+
+
+def name(names, value):
+    return names[value] if value < len(names) else "UNKNOWN({})".format(value)
+
+
+def decode(line):
+    data = bytes.fromhex(line.split(MARKER, 1)[1].strip())
+    version, adapter, count = struct.unpack_from("<BBH", data)
+    if version != FORMAT_VERSION:
+        raise ValueError("unsupported trace format version {}".format(version))
+
+    print("Adapter: {}, {} transitions".format(name(ADAPTERS, adapter), count))
+    previous_ms = None
+    for i in range(count):
+        timestamp_ms, states, reason = ENTRY.unpack_from(data, 4 + i * ENTRY.size)
+        delta = "" if previous_ms is None else "+{}".format((timestamp_ms - previous_ms) & 0xFFFFFFFF)
+        print("{:>10} ms {:>10}  {:>13} -> {:<13} {}".format(
+            timestamp_ms, delta, name(STATES, states >> 4), name(STATES, states & 0x0F), name(REASONS, reason)))
+        previous_ms = timestamp_ms
+
+
+def main():
+    log = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    found = False
+    for line in log:
+        if MARKER in line:
+            decode(line)
+            found = True
+    if not found:
+        sys.exit("No " + MARKER + " line found")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_BASIC_CONNECTION_HANDLER_H_
+#define ARDUINO_BASIC_CONNECTION_HANDLER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "Arduino_ConnectionHandler.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Statically dispatched variant of a connection handler, for firmware using a
+ * single, known adapter, e.g. BasicConnectionHandler<WiFiConnectionHandler>.
+ * It is constructed with the same arguments as the adapter. Its check() calls
+ * the update_handle*() functions of the adapter directly instead of through
+ * the vtable, and being final lets the compiler resolve the other virtual
+ * calls (getClient(), getTime(), ...) made on it statically as well.
+ *
+ * It still is an Adapter, and thus a ConnectionHandler, so it can be passed
+ * wherever a ConnectionHandler & is expected; check() called through such a
+ * reference takes the virtual path, with the same behaviour.
+ */
+template <class Adapter>
+class BasicConnectionHandler final : public Adapter
+{
+  public:
+
+    template <typename... Args>
+    BasicConnectionHandler(Args &&... args)
+    : Adapter(static_cast<Args &&>(args)...)
+    { }
+
+    NetworkConnectionState check()
+    {
+      if (this->isCheckDue())
+      {
+        NetworkConnectionState next_net_connection_state = this->currentState();
+
+        switch (this->currentState())
+        {
+          case NetworkConnectionState::INIT:          next_net_connection_state = this->Adapter::update_handleInit         (); break;
+          case NetworkConnectionState::CONNECTING:    next_net_connection_state = this->Adapter::update_handleConnecting   (); break;
+          case NetworkConnectionState::CONNECTED:     next_net_connection_state = this->Adapter::update_handleConnected    (); break;
+          case NetworkConnectionState::DISCONNECTING: next_net_connection_state = this->Adapter::update_handleDisconnecting(); break;
+          case NetworkConnectionState::DISCONNECTED:  next_net_connection_state = this->Adapter::update_handleDisconnected (); break;
+          case NetworkConnectionState::ERROR:                                                                                 break;
+          case NetworkConnectionState::CLOSED:                                                                                break;
+        }
+
+        this->updateState(next_net_connection_state);
+      }
+
+      return this->currentState();
+    }
+};
+
+#endif /* ARDUINO_BASIC_CONNECTION_HANDLER_H_ */
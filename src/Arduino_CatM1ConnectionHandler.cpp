@@ -20,9 +20,17 @@
  ******************************************************************************/
 
 #include "Arduino_CatM1ConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #ifdef BOARD_HAS_CATM1_NBIOT /* Only compile if the board has CatM1 BN-IoT */
 
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static uint32_t const CATM1_RETRY_BACKOFF_BASE = 5000;
+static uint32_t const CATM1_RETRY_BACKOFF_MAX = 300000;
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -35,8 +43,14 @@ CatM1ConnectionHandler::CatM1ConnectionHandler(const char * pin, const char * ap
 , _pass(pass)
 , _rat(rat)
 , _band(band)
+, _stage(Stage::POWER_UP)
+, _registration_attempts(0)
+, _last_registration_duration_ms(0)
 {
-
+  /* Registration failures are usually transient (coverage, network busy),
+   * hence retries are spaced out instead of giving up.
+   */
+  enableReconnectBackoff(CATM1_RETRY_BACKOFF_BASE, CATM1_RETRY_BACKOFF_MAX);
 }
 
 /******************************************************************************
@@ -45,7 +59,12 @@ CatM1ConnectionHandler::CatM1ConnectionHandler(const char * pin, const char * ap
 
 unsigned long CatM1ConnectionHandler::getTime()
 {
-  return GSM.getTime();
+  unsigned long time = getCachedTime();
+  if (!time) {
+    time = GSM.getTime();
+    updateTimeCache(time);
+  }
+  return time;
 }
 
 /******************************************************************************
@@ -58,17 +77,32 @@ NetworkConnectionState CatM1ConnectionHandler::update_handleInit()
   pinMode(ON_MKR2, OUTPUT);
   digitalWrite(ON_MKR2, HIGH);
 #endif
+  _registration_attempts = 0;
+  _stage = Stage::REGISTRATION;
   return NetworkConnectionState::CONNECTING;
 }
 
 NetworkConnectionState CatM1ConnectionHandler::update_handleConnecting()
 {
-  if(!GSM.begin(_pin, _apn, _login, _pass, _rat, _band))
+  /* The modem is only restarted on the first attempt, retries reuse it */
+  bool const restart = (_registration_attempts == 0);
+  _stage = Stage::REGISTRATION;
+  _registration_attempts++;
+
+  unsigned long const start_ms = millis();
+  int const registered = GSM.begin(_pin, _apn, _login, _pass, _rat, _band, restart);
+  _last_registration_duration_ms = millis() - start_ms;
+
+  if(!registered)
   {
-    Debug.print(DBG_ERROR, F("The board was not able to register to the network..."));
-    return NetworkConnectionState::ERROR;
+    CH_LOG_ERROR("The board was not able to register to the network...");
+    CH_LOG_INFO("Registration attempt %u failed after %lu milliseconds, retrying", _registration_attempts, _last_registration_duration_ms);
+    _stage = Stage::RETRY_WAIT;
+    connectionAttemptFailed();
+    return NetworkConnectionState::CONNECTING;
   }
-  Debug.print(DBG_INFO, F("Connected to Network"));
+  CH_LOG_INFO("Connected to Network");
+  _stage = Stage::CONNECTED;
   return NetworkConnectionState::CONNECTED;
 }
 
@@ -77,6 +111,8 @@ NetworkConnectionState CatM1ConnectionHandler::update_handleConnected()
   int const is_gsm_access_alive = GSM.isConnected();
   if (is_gsm_access_alive != 1)
   {
+    _stage = Stage::DISCONNECTED;
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   return NetworkConnectionState::CONNECTED;
@@ -84,6 +120,7 @@ NetworkConnectionState CatM1ConnectionHandler::update_handleConnected()
 
 NetworkConnectionState CatM1ConnectionHandler::update_handleDisconnecting()
 {
+  _stage = Stage::DISCONNECTED;
   GSM.disconnect();
   return NetworkConnectionState::DISCONNECTED;
 }
@@ -35,6 +35,18 @@ class CatM1ConnectionHandler : public ConnectionHandler
 {
   public:
 
+    enum class Stage : uint8_t
+    {
+      POWER_UP,
+      REGISTRATION,
+      RETRY_WAIT,
+      CONNECTED,
+      DISCONNECTED
+    };
+
+    /* A failed registration is retried, spaced out by the reconnect backoff
+     * (5 s doubling up to 300 s by default, see enableReconnectBackoff()).
+     */
     CatM1ConnectionHandler(const char * pin, const char * apn, const char * login, const char * pass, RadioAccessTechnologyType rat = CATM1, uint32_t band = BAND_3 | BAND_20 | BAND_19, bool const keep_alive = true);
 
 
@@ -42,6 +54,11 @@ class CatM1ConnectionHandler : public ConnectionHandler
     virtual Client & getClient() override { return _gsm_client; };
     virtual UDP & getUDP() override { return _gsm_udp; };
 
+    /* Progress of the network registration */
+    Stage getStage() const { return _stage; }
+    uint16_t getRegistrationAttempts() const { return _registration_attempts; }
+    unsigned long getLastRegistrationDuration() const { return _last_registration_duration_ms; }
+
 
   protected:
 
@@ -64,6 +81,10 @@ class CatM1ConnectionHandler : public ConnectionHandler
 
     GSMUDP _gsm_udp;
     GSMClient _gsm_client;
+
+    Stage _stage;
+    uint16_t _registration_attempts;
+    unsigned long _last_registration_duration_ms;
 };
 
 #endif /* #ifdef BOARD_HAS_CATM1_NBIOT  */
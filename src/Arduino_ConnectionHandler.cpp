@@ -21,17 +21,60 @@
 
 #include "Arduino_ConnectionHandler.h"
 
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+CheckIntervalTable const DEFAULT_CHECK_INTERVAL_TABLE =
+{{
+  /* INIT          */ 100,
+#if defined(ARDUINO_ARCH_ESP32)
+  /* CONNECTING    */ 4000,
+#else
+  /* CONNECTING    */ 500,
+#endif
+  /* CONNECTED     */ 10000,
+  /* DISCONNECTING */ 100,
+  /* DISCONNECTED  */ 1000,
+  /* CLOSED        */ 1000,
+  /* ERROR         */ 1000
+}};
+
+/* With a baseline of one hour, the one second resolution of the time source
+ * bounds the drift error to 278 ppm, and to 12 ppm after a day. Oscillators
+ * drifting more than 5% are not expected, such an error is a time step.
+ */
+static uint32_t const TIME_DRIFT_MIN_BASELINE_MS = 3600000UL;
+static uint32_t const TIME_DRIFT_MAX_BASELINE_MS = 0x80000000UL;
+static int32_t const TIME_DRIFT_MAX_PPM = 50000;
+
+/******************************************************************************
+   LOCAL FUNCTIONS
+ ******************************************************************************/
+
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+static void printHexByte(Print & out, uint8_t const b)
+{
+  static char const HEX_DIGITS[] = "0123456789ABCDEF";
+  out.write(HEX_DIGITS[b >> 4]);
+  out.write(HEX_DIGITS[b & 0x0F]);
+}
+#endif
+
 /******************************************************************************
    CONSTRUCTOR/DESTRUCTOR
  ******************************************************************************/
 
-ConnectionHandler::ConnectionHandler(bool const keep_alive, NetworkAdapter interface)
+ConnectionHandler::ConnectionHandler(bool const keep_alive, NetworkAdapter interface, CheckIntervalTable const & check_intervals)
 : _keep_alive{keep_alive}
 , _interface{interface}
+, _check_intervals(check_intervals)
 , _lastConnectionTickTime{millis()}
 , _current_net_connection_state{NetworkConnectionState::INIT}
+, _connect_start_ms(millis())
+, _outage{false}
 {
-
+  resetMetrics();
 }
 
 /******************************************************************************
@@ -40,12 +83,8 @@ ConnectionHandler::ConnectionHandler(bool const keep_alive, NetworkAdapter inter
 
 NetworkConnectionState ConnectionHandler::check()
 {
-  unsigned long const now = millis();
-  unsigned int const connectionTickTimeInterval = CHECK_INTERVAL_TABLE[static_cast<unsigned int>(_current_net_connection_state)];
-
-  if((now - _lastConnectionTickTime) > connectionTickTimeInterval)
+  if(isCheckDue())
   {
-    _lastConnectionTickTime = now;
     NetworkConnectionState next_net_connection_state = _current_net_connection_state;
 
     /* While the state machine is implemented here, the concrete implementation of the
@@ -62,38 +101,53 @@ NetworkConnectionState ConnectionHandler::check()
       case NetworkConnectionState::CLOSED:                                                                  break;
     }
 
-    /* Here we are determining whether a state transition from one state to the next has
-     * occurred - and if it has, we call eventually registered callbacks.
-     */
-    if(next_net_connection_state != _current_net_connection_state)
-    {
-      /* Check the next state to determine the kind of state conversion which has occurred (and call the appropriate callback) */
-      if(next_net_connection_state == NetworkConnectionState::CONNECTED)
-      {
-        if(_on_connect_event_callback) _on_connect_event_callback();
-      }
-      if(next_net_connection_state == NetworkConnectionState::DISCONNECTED)
-      {
-        if(_on_disconnect_event_callback) _on_disconnect_event_callback();
-      }
-      if(next_net_connection_state == NetworkConnectionState::ERROR)
-      {
-        if(_on_error_event_callback) _on_error_event_callback();
-      }
-
-      /* Assign new state to the member variable holding the state */
-      _current_net_connection_state = next_net_connection_state;
-    }
+    updateState(next_net_connection_state);
   }
 
   return _current_net_connection_state;
 }
 
+unsigned long ConnectionHandler::nextCheckDue()
+{
+  unsigned long const elapsed = millis() - _lastConnectionTickTime;
+  unsigned long const connectionTickTimeInterval = currentCheckInterval();
+
+  /* check() only runs the state machine once the interval has been exceeded */
+  if (elapsed > connectionTickTimeInterval)
+    return 0;
+  else
+    return connectionTickTimeInterval - elapsed + 1;
+}
+
+void ConnectionHandler::enableReconnectBackoff(uint32_t const base_ms, uint32_t const max_ms, uint8_t const multiplier, uint8_t const jitter_percent, uint32_t const seed)
+{
+  _backoff_base_ms = base_ms;
+  _backoff_max_ms = (max_ms < base_ms) ? base_ms : max_ms;
+  _backoff_multiplier = (multiplier < 1) ? 1 : multiplier;
+  _backoff_jitter_percent = (jitter_percent > 100) ? 100 : jitter_percent;
+  _backoff_random = seed;
+  _backoff_attempt = 0;
+  _backoff_delay_ms = 0;
+}
+
+void ConnectionHandler::disableReconnectBackoff()
+{
+  _backoff_base_ms = 0;
+  _backoff_attempt = 0;
+  _backoff_delay_ms = 0;
+}
+
 void ConnectionHandler::connect()
 {
   if (_current_net_connection_state != NetworkConnectionState::INIT && _current_net_connection_state != NetworkConnectionState::CONNECTING)
   {
     _keep_alive = true;
+    _backoff_attempt = 0;
+    _backoff_delay_ms = 0;
+    _connect_start_ms = millis();
+    _outage = false;
+    setTransitionReason(TransitionReason::USER_REQUEST);
+    recordTransition(NetworkConnectionState::INIT);
     _current_net_connection_state = NetworkConnectionState::INIT;
   }
 }
@@ -101,9 +155,56 @@ void ConnectionHandler::connect()
 void ConnectionHandler::disconnect()
 {
   _keep_alive = false;
+  _backoff_delay_ms = 0;
+  if (_current_net_connection_state != NetworkConnectionState::DISCONNECTING)
+  {
+    setTransitionReason(TransitionReason::USER_REQUEST);
+    recordTransition(NetworkConnectionState::DISCONNECTING);
+  }
   _current_net_connection_state = NetworkConnectionState::DISCONNECTING;
 }
 
+void ConnectionHandler::resetMetrics()
+{
+  memset(&_metrics, 0, sizeof(_metrics));
+  _metrics.entries[static_cast<unsigned int>(_current_net_connection_state)] = 1;
+  _metrics.last_transition_ms = millis();
+}
+
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+size_t ConnectionHandler::getTrace(TransitionTraceEntry * entries, size_t const max_entries) const
+{
+  size_t const count = (_trace_count < max_entries) ? _trace_count : max_entries;
+  size_t const oldest = (_trace_head + CONNECTION_HANDLER_TRACE_SIZE - _trace_count) % CONNECTION_HANDLER_TRACE_SIZE;
+
+  for (size_t i = 0; i < count; i++)
+    entries[i] = _trace[(oldest + i) % CONNECTION_HANDLER_TRACE_SIZE];
+
+  return count;
+}
+
+void ConnectionHandler::dumpTrace(Print & out) const
+{
+  /* Header: format version, adapter, number of entries (little endian) */
+  out.write(reinterpret_cast<uint8_t const *>("CHTRACE:"), 8);
+  printHexByte(out, 1);
+  printHexByte(out, static_cast<uint8_t>(_interface));
+  printHexByte(out, _trace_count & 0xFF);
+  printHexByte(out, _trace_count >> 8);
+
+  size_t const oldest = (_trace_head + CONNECTION_HANDLER_TRACE_SIZE - _trace_count) % CONNECTION_HANDLER_TRACE_SIZE;
+  for (size_t i = 0; i < _trace_count; i++)
+  {
+    TransitionTraceEntry const & entry = _trace[(oldest + i) % CONNECTION_HANDLER_TRACE_SIZE];
+    for (unsigned int shift = 0; shift < 32; shift += 8)
+      printHexByte(out, (entry.timestamp_ms >> shift) & 0xFF);
+    printHexByte(out, entry.states);
+    printHexByte(out, entry.reason);
+  }
+  out.write('\n');
+}
+#endif
+
 void ConnectionHandler::addCallback(NetworkConnectionEvent const event, OnNetworkEventCallback callback)
 {
   switch (event)
@@ -111,6 +212,7 @@ void ConnectionHandler::addCallback(NetworkConnectionEvent const event, OnNetwor
     case NetworkConnectionEvent::CONNECTED:    _on_connect_event_callback    = callback; break;
     case NetworkConnectionEvent::DISCONNECTED: _on_disconnect_event_callback = callback; break;
     case NetworkConnectionEvent::ERROR:        _on_error_event_callback      = callback; break;
+    case NetworkConnectionEvent::FIRMWARE_OUTDATED: _on_firmware_outdated_event_callback = callback; break;
   }
 }
 
@@ -123,3 +225,218 @@ void ConnectionHandler::addDisconnectCallback(OnNetworkEventCallback callback) {
 void ConnectionHandler::addErrorCallback(OnNetworkEventCallback callback) {
   _on_error_event_callback = callback;
 }
+
+/******************************************************************************
+   PROTECTED MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool ConnectionHandler::isCheckDue()
+{
+  unsigned long const now = millis();
+  unsigned long const connectionTickTimeInterval = currentCheckInterval();
+
+  if((now - _lastConnectionTickTime) > connectionTickTimeInterval)
+  {
+    _lastConnectionTickTime = now;
+    /* The backoff delay only ever postpones the first check after a failure */
+    _backoff_delay_ms = 0;
+    return true;
+  }
+  return false;
+}
+
+void ConnectionHandler::updateState(NetworkConnectionState const next_net_connection_state)
+{
+  /* Delay the reconnection after a connection loss according to the reconnect
+   * backoff configuration (if enabled). The failed attempts are reported by
+   * the adapters through connectionAttemptFailed().
+   */
+  if(_backoff_base_ms)
+  {
+    if(next_net_connection_state == NetworkConnectionState::CONNECTED)
+    {
+      _backoff_attempt = 0;
+      _backoff_delay_ms = 0;
+    }
+    else if(_current_net_connection_state == NetworkConnectionState::CONNECTED)
+    {
+      _backoff_attempt = 0;
+      _backoff_delay_ms = nextBackoffDelay();
+    }
+  }
+
+  /* Here we are determining whether a state transition from one state to the next has
+   * occurred - and if it has, we call eventually registered callbacks.
+   */
+  if(next_net_connection_state != _current_net_connection_state)
+  {
+    /* Check the next state to determine the kind of state conversion which has occurred (and call the appropriate callback) */
+    if(next_net_connection_state == NetworkConnectionState::CONNECTED)
+    {
+      if(_on_connect_event_callback) _on_connect_event_callback();
+    }
+    if(next_net_connection_state == NetworkConnectionState::DISCONNECTED)
+    {
+      if(_on_disconnect_event_callback) _on_disconnect_event_callback();
+    }
+    if(next_net_connection_state == NetworkConnectionState::ERROR)
+    {
+      if(_on_error_event_callback) _on_error_event_callback();
+    }
+
+    /* Assign new state to the member variable holding the state */
+    recordTransition(next_net_connection_state);
+    _current_net_connection_state = next_net_connection_state;
+  }
+}
+
+void ConnectionHandler::connectionAttemptFailed()
+{
+  if(_backoff_base_ms)
+    _backoff_delay_ms = nextBackoffDelay();
+}
+
+unsigned long ConnectionHandler::getCachedTime()
+{
+  if (!_time_cache_interval_ms || !_time_cache_epoch)
+    return 0;
+
+  /* Unsigned arithmetic keeps the elapsed time correct across a millis()
+   * rollover (provided the cache is read at least once every ~49 days).
+   */
+  uint32_t const elapsed_ms = millis() - _time_cache_ms;
+  if (elapsed_ms >= _time_cache_interval_ms)
+    return 0;
+
+  return _time_cache_epoch + (elapsed_ms / 1000);
+}
+
+void ConnectionHandler::updateTimeCache(unsigned long const time)
+{
+  /* 0 signals that the time source failed: keep reading from it */
+  if (!_time_cache_interval_ms || !time)
+    return;
+
+  uint32_t const now = millis();
+
+  /* The drift is estimated against the first reading rather than the previous
+   * one: the source has a resolution of one second, which over the baseline
+   * (at least TIME_DRIFT_MIN_BASELINE_MS) is a bounded error in ppm. An error
+   * beyond TIME_DRIFT_MAX_PPM is a step of the source time, not drift, and
+   * restarts the baseline, as does a baseline about to overflow millis().
+   */
+  uint32_t const baseline_ms = now - _time_base_ms;
+  if (!_time_base_epoch || (baseline_ms >= TIME_DRIFT_MAX_BASELINE_MS))
+  {
+    _time_base_epoch = time;
+    _time_base_ms = now;
+  }
+  else if (baseline_ms >= TIME_DRIFT_MIN_BASELINE_MS)
+  {
+    int64_t const error_ms = (static_cast<int64_t>(time) - static_cast<int64_t>(_time_base_epoch)) * 1000LL - baseline_ms;
+    int64_t const drift_ppm = (error_ms * 1000000LL) / baseline_ms;
+    if ((drift_ppm > TIME_DRIFT_MAX_PPM) || (drift_ppm < -TIME_DRIFT_MAX_PPM))
+    {
+      _time_base_epoch = time;
+      _time_base_ms = now;
+    }
+    else
+    {
+      _time_drift_ppm = static_cast<int32_t>(drift_ppm);
+    }
+  }
+
+  _time_cache_epoch = time;
+  _time_cache_ms = now;
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void ConnectionHandler::recordTransition(NetworkConnectionState const next_state)
+{
+  uint32_t const now = millis();
+
+  _metrics.dwell_ms[static_cast<unsigned int>(_current_net_connection_state)] += now - _metrics.last_transition_ms;
+  _metrics.entries[static_cast<unsigned int>(next_state)]++;
+  _metrics.last_transition_ms = now;
+
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+  TransitionTraceEntry & entry = _trace[_trace_head];
+  entry.timestamp_ms = now;
+  entry.states = (static_cast<uint8_t>(_current_net_connection_state) << 4) | static_cast<uint8_t>(next_state);
+  entry.reason = static_cast<uint8_t>(_transition_reason);
+  _trace_head = (_trace_head + 1) % CONNECTION_HANDLER_TRACE_SIZE;
+  if (_trace_count < CONNECTION_HANDLER_TRACE_SIZE)
+    _trace_count++;
+  _transition_reason = TransitionReason::NONE;
+#endif
+
+  if (next_state == NetworkConnectionState::CONNECTED)
+  {
+    uint32_t const time_to_connect_ms = now - _connect_start_ms;
+    unsigned int bucket = 0;
+    for (uint32_t limit_ms = 1000; bucket < (CONNECTION_METRICS_TTC_BUCKETS - 1) && time_to_connect_ms >= limit_ms; limit_ms *= 4)
+      bucket++;
+    _metrics.time_to_connect[bucket]++;
+
+    if (_outage && time_to_connect_ms > _metrics.longest_outage_ms)
+      _metrics.longest_outage_ms = time_to_connect_ms;
+  }
+  else if (_current_net_connection_state == NetworkConnectionState::CONNECTED)
+  {
+    /* The connection was lost (or closed): measure until it is back */
+    _connect_start_ms = now;
+    _outage = true;
+  }
+}
+
+unsigned long ConnectionHandler::currentCheckInterval() const
+{
+  unsigned long const interval = getCheckInterval(_current_net_connection_state);
+
+  /* The reconnect backoff only ever stretches the retry cadence */
+  if (_backoff_delay_ms > interval &&
+      (_current_net_connection_state == NetworkConnectionState::INIT ||
+       _current_net_connection_state == NetworkConnectionState::CONNECTING ||
+       _current_net_connection_state == NetworkConnectionState::DISCONNECTED))
+    return _backoff_delay_ms;
+  else
+    return interval;
+}
+
+uint32_t ConnectionHandler::nextBackoffDelay()
+{
+  /* base * multiplier ^ attempt, saturated at the configured maximum */
+  uint32_t delay_ms = _backoff_base_ms;
+  for (uint16_t i = 0; i < _backoff_attempt && delay_ms < _backoff_max_ms; i++)
+  {
+    if (delay_ms > (_backoff_max_ms / _backoff_multiplier))
+      delay_ms = _backoff_max_ms;
+    else
+      delay_ms *= _backoff_multiplier;
+  }
+  if (delay_ms > _backoff_max_ms)
+    delay_ms = _backoff_max_ms;
+
+  if (_backoff_attempt < 0xFFFF)
+    _backoff_attempt++;
+
+  /* Randomly shorten the delay by up to jitter_percent, so that devices which
+   * lost the connection at the same time do not retry in lockstep.
+   */
+  uint32_t const jitter_ms = (delay_ms / 100) * _backoff_jitter_percent;
+  if (jitter_ms)
+  {
+    /* xorshift32 must never be seeded with 0 */
+    if (!_backoff_random)
+      _backoff_random = 0x9E3779B9UL ^ micros();
+    _backoff_random ^= _backoff_random << 13;
+    _backoff_random ^= _backoff_random >> 17;
+    _backoff_random ^= _backoff_random << 5;
+    delay_ms -= _backoff_random % (jitter_ms + 1);
+  }
+
+  return delay_ms;
+}
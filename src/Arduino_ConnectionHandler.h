@@ -195,10 +195,13 @@ enum class NetworkConnectionState : unsigned int {
   ERROR         = 6
 };
 
+#define NETWORK_CONNECTION_STATE_COUNT 7
+
 enum class NetworkConnectionEvent {
   CONNECTED,
   DISCONNECTED,
-  ERROR
+  ERROR,
+  FIRMWARE_OUTDATED
 };
 
 enum class NetworkAdapter {
@@ -213,24 +216,80 @@ enum class NetworkAdapter {
 
 typedef void (*OnNetworkEventCallback)();
 
+/* Interval in milliseconds in between two consecutive runs of the state
+ * machine, for each NetworkConnectionState. The intervals are listed in the
+ * order of the numerical values of NetworkConnectionState, and can be accessed
+ * by state with operator[].
+ */
+struct CheckIntervalTable {
+  uint32_t intervals[NETWORK_CONNECTION_STATE_COUNT];
+
+  uint32_t & operator[](NetworkConnectionState const state) {
+    return intervals[static_cast<unsigned int>(state)];
+  }
+  uint32_t operator[](NetworkConnectionState const state) const {
+    return intervals[static_cast<unsigned int>(state)];
+  }
+};
+
+/* Connection statistics, updated on every state transition. Arrays are indexed
+ * by the numerical value of NetworkConnectionState. The time spent in the
+ * current state is only added to dwell_ms when leaving it; it can be computed
+ * as millis() - last_transition_ms.
+ *
+ * Time to connect is measured from the start (or loss) of the connection to
+ * CONNECTED. Bucket i of time_to_connect counts the connections established
+ * in less than 1 s * 4^i, the last bucket counts all the slower ones.
+ */
+#define CONNECTION_METRICS_TTC_BUCKETS 6
+
+struct ConnectionMetrics {
+  uint32_t dwell_ms[NETWORK_CONNECTION_STATE_COUNT];
+  uint32_t entries[NETWORK_CONNECTION_STATE_COUNT];
+  uint32_t last_transition_ms;
+  uint32_t longest_outage_ms;
+  uint32_t time_to_connect[CONNECTION_METRICS_TTC_BUCKETS];
+};
+
+/* Optional trace of the last CONNECTION_HANDLER_TRACE_SIZE state transitions,
+ * kept in a ring buffer inside each handler (6 bytes per entry, no heap). It
+ * is disabled (0) by default, define it in the build flags to enable it. The
+ * output of dumpTrace() can be decoded with extras/tools/decode_trace.py.
+ */
+#ifndef CONNECTION_HANDLER_TRACE_SIZE
+  #define CONNECTION_HANDLER_TRACE_SIZE 0
+#endif
+
+/* Why a handler left its previous state, as recorded in the trace */
+enum class TransitionReason : uint8_t {
+  NONE               = 0,
+  USER_REQUEST       = 1,
+  HARDWARE_ERROR     = 2,
+  TIMEOUT            = 3,
+  AUTH_FAILED        = 4,
+  ATTACH_FAILED      = 5,
+  CONNECTION_LOST    = 6,
+  CONFIG_FAILED      = 7
+};
+
+struct __attribute__((packed)) TransitionTraceEntry {
+  uint32_t timestamp_ms;
+  uint8_t states;   /* previous state in the high nibble, next one in the low nibble */
+  uint8_t reason;   /* TransitionReason */
+};
+
 /******************************************************************************
    CONSTANTS
  ******************************************************************************/
 
-static unsigned int const CHECK_INTERVAL_TABLE[] =
-{
-  /* INIT          */ 100,
-#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
-  /* CONNECTING    */ 4000,
-#else
-  /* CONNECTING    */ 500,
-#endif
-  /* CONNECTED     */ 10000,
-  /* DISCONNECTING */ 100,
-  /* DISCONNECTED  */ 1000,
-  /* CLOSED        */ 1000,
-  /* ERROR         */ 1000
-};
+/* Default check intervals, shared by all handler instances */
+extern CheckIntervalTable const DEFAULT_CHECK_INTERVAL_TABLE;
+
+/* Former name of the default check intervals, indexed by the numerical value
+ * of NetworkConnectionState. Use DEFAULT_CHECK_INTERVAL_TABLE, or the
+ * getCheckInterval() of a handler which may have its own intervals.
+ */
+static uint32_t const (& CHECK_INTERVAL_TABLE)[NETWORK_CONNECTION_STATE_COUNT] __attribute__((deprecated)) = DEFAULT_CHECK_INTERVAL_TABLE.intervals;
 
 /******************************************************************************
    CLASS DECLARATION
@@ -239,10 +298,16 @@ static unsigned int const CHECK_INTERVAL_TABLE[] =
 class ConnectionHandler {
   public:
 
-    ConnectionHandler(bool const keep_alive, NetworkAdapter interface);
+    ConnectionHandler(bool const keep_alive, NetworkAdapter interface, CheckIntervalTable const & check_intervals = DEFAULT_CHECK_INTERVAL_TABLE);
 
     NetworkConnectionState check();
 
+    /* Returns the number of milliseconds until the next call to check() will
+     * actually advance the state machine, 0 if it is already due. This allows
+     * the application to sleep in between calls to check().
+     */
+    unsigned long nextCheckDue();
+
     #if defined(BOARD_HAS_WIFI) || defined(BOARD_HAS_GSM) || defined(BOARD_HAS_NB) || defined(BOARD_HAS_ETHERNET) || defined(BOARD_HAS_CATM1_NBIOT)
       virtual Client &getClient() = 0;
       virtual UDP &getUDP() = 0;
@@ -256,6 +321,16 @@ class ConnectionHandler {
       virtual int write(const uint8_t *buf, size_t size) = 0;
       virtual int read() = 0;
       virtual bool available() = 0;
+
+      /* Bulk access to the payload received: read() copies up to len bytes and
+       * returns the number of bytes copied, peek() returns the next byte without
+       * consuming it (or a negative value if none), and payloadSize() returns the
+       * number of bytes left to read. As for read(), available() must be called
+       * first to receive the next payload.
+       */
+      virtual int read(uint8_t *buf, size_t len) = 0;
+      virtual int peek() = 0;
+      virtual size_t payloadSize() = 0;
     #endif
 
     NetworkConnectionState getStatus() __attribute__((deprecated)) {
@@ -269,6 +344,54 @@ class ConnectionHandler {
     void connect();
     void disconnect();
 
+    void setCheckIntervalTable(CheckIntervalTable const & check_intervals) {
+      _check_intervals = check_intervals;
+    }
+    void setCheckInterval(NetworkConnectionState const state, uint32_t const interval_ms) {
+      _check_intervals[state] = interval_ms;
+    }
+    uint32_t getCheckInterval(NetworkConnectionState const state) const {
+      return _check_intervals[state];
+    }
+
+    /* Space out reconnection attempts: after a connection loss, and after every
+     * failed connection attempt, the next check is delayed by
+     * base_ms * multiplier ^ attempt (at most max_ms), randomly shortened by up
+     * to jitter_percent. The checks polling an attempt still in progress are
+     * not delayed. The seed should be unique per device (e.g. derived from its
+     * MAC address or serial number).
+     */
+    void enableReconnectBackoff(uint32_t const base_ms, uint32_t const max_ms, uint8_t const multiplier = 2, uint8_t const jitter_percent = 50, uint32_t const seed = 0);
+    void disableReconnectBackoff();
+
+    /* Serve getTime() from a cache refreshed from the network time source at
+     * most every interval_ms, extrapolated with millis() in between (0, the
+     * default, disables the cache). getTimeDrift() estimates how fast millis()
+     * drifts from the time source, in parts per million (positive if slow),
+     * once the readings span at least an hour (0 until then).
+     */
+    void setTimeCacheInterval(uint32_t const interval_ms) {
+      _time_cache_interval_ms = interval_ms;
+      _time_cache_epoch = 0;
+    }
+    int32_t getTimeDrift() const {
+      return _time_drift_ppm;
+    }
+
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+    /* Copies up to max_entries of the traced transitions, oldest first, and
+     * returns the number of entries copied. dumpTrace() prints the whole trace
+     * as a single hex encoded "CHTRACE:" line.
+     */
+    size_t getTrace(TransitionTraceEntry * entries, size_t const max_entries) const;
+    void dumpTrace(Print & out) const;
+#endif
+
+    ConnectionMetrics const & getMetrics() const {
+      return _metrics;
+    }
+    void resetMetrics();
+
     void addCallback(NetworkConnectionEvent const event, OnNetworkEventCallback callback);
     void addConnectCallback(OnNetworkEventCallback callback) __attribute__((deprecated));
     void addDisconnectCallback(OnNetworkEventCallback callback) __attribute__((deprecated));
@@ -285,13 +408,81 @@ class ConnectionHandler {
     virtual NetworkConnectionState update_handleDisconnecting() = 0;
     virtual NetworkConnectionState update_handleDisconnected () = 0;
 
+    /* Building blocks of check(), shared with BasicConnectionHandler: whether
+     * the state machine is due to run (restarting the check interval if so),
+     * and the bookkeeping of the state returned by the update_handle*() call.
+     */
+    bool isCheckDue();
+    NetworkConnectionState currentState() const {
+      return _current_net_connection_state;
+    }
+    void updateState(NetworkConnectionState const next_net_connection_state);
+
+    /* To be called by the adapters when a connection attempt has actually
+     * failed or timed out (and not while it is still in progress), so that
+     * the next attempt is delayed according to the reconnect backoff.
+     */
+    void connectionAttemptFailed();
+
+    /* To be used by getTime(): getCachedTime() returns the cached time
+     * extrapolated to now, or 0 when the time has to be read from the source,
+     * which must then be passed to updateTimeCache().
+     */
+    unsigned long getCachedTime();
+    void updateTimeCache(unsigned long const time);
+
+    /* Records the reason of the state transition about to be returned */
+    void setTransitionReason(TransitionReason const reason) {
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+      _transition_reason = reason;
+#else
+      (void)reason;
+#endif
+    }
+
+    void notifyFirmwareOutdated() {
+      if(_on_firmware_outdated_event_callback) _on_firmware_outdated_event_callback();
+    }
+
   private:
 
+    CheckIntervalTable _check_intervals;
     unsigned long _lastConnectionTickTime;
     NetworkConnectionState _current_net_connection_state;
     OnNetworkEventCallback _on_connect_event_callback = NULL,
                            _on_disconnect_event_callback = NULL,
-                           _on_error_event_callback = NULL;
+                           _on_error_event_callback = NULL,
+                           _on_firmware_outdated_event_callback = NULL;
+
+    uint32_t _backoff_base_ms = 0;
+    uint32_t _backoff_max_ms = 0;
+    uint32_t _backoff_delay_ms = 0;
+    uint32_t _backoff_random = 0;
+    uint16_t _backoff_attempt = 0;
+    uint8_t _backoff_multiplier = 2;
+    uint8_t _backoff_jitter_percent = 0;
+
+    uint32_t _time_cache_interval_ms = 0;
+    uint32_t _time_cache_ms = 0;
+    unsigned long _time_cache_epoch = 0;
+    uint32_t _time_base_ms = 0;
+    unsigned long _time_base_epoch = 0;
+    int32_t _time_drift_ppm = 0;
+
+    ConnectionMetrics _metrics;
+    uint32_t _connect_start_ms;
+    bool _outage;
+
+#if CONNECTION_HANDLER_TRACE_SIZE > 0
+    TransitionTraceEntry _trace[CONNECTION_HANDLER_TRACE_SIZE];
+    uint16_t _trace_head = 0;
+    uint16_t _trace_count = 0;
+    TransitionReason _transition_reason = TransitionReason::NONE;
+#endif
+
+    unsigned long currentCheckInterval() const;
+    void recordTransition(NetworkConnectionState const next_state);
+    uint32_t nextBackoffDelay();
 };
 
 #if defined(USE_NOTECARD)
@@ -316,4 +507,10 @@ class ConnectionHandler {
   #include "Arduino_CatM1ConnectionHandler.h"
 #endif
 
+#if defined(BOARD_HAS_WIFI) || defined(BOARD_HAS_GSM) || defined(BOARD_HAS_NB) || defined(BOARD_HAS_ETHERNET) || defined(BOARD_HAS_CATM1_NBIOT)
+  #include "Arduino_FailoverConnectionHandler.h"
+#endif
+
+#include "Arduino_BasicConnectionHandler.h"
+
 #endif /* CONNECTION_HANDLER_H_ */
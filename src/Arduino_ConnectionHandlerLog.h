@@ -0,0 +1,193 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_CONNECTION_HANDLER_LOG_H_
+#define ARDUINO_CONNECTION_HANDLER_LOG_H_
+
+/******************************************************************************
+   INCLUDES
+ ******************************************************************************/
+
+#include "Arduino_ConnectionHandler.h"
+
+/******************************************************************************
+   DEFINES
+ ******************************************************************************/
+
+/* Log messages of the connection handlers. The messages above
+ * CONNECTION_HANDLER_LOG_LEVEL are removed at compile time, together with
+ * their format strings, instead of only being filtered at runtime by the
+ * Debug level. The format string must be a string literal, it is wrapped
+ * in F() here.
+ */
+#define CONNECTION_HANDLER_LOG_LEVEL_NONE     -1
+#define CONNECTION_HANDLER_LOG_LEVEL_ERROR     0
+#define CONNECTION_HANDLER_LOG_LEVEL_WARNING   1
+#define CONNECTION_HANDLER_LOG_LEVEL_INFO      2
+#define CONNECTION_HANDLER_LOG_LEVEL_DEBUG     3
+#define CONNECTION_HANDLER_LOG_LEVEL_VERBOSE   4
+
+/* Arduino_DebugUtils is not available on AVR, hence nothing is logged there */
+#if defined(__AVR__)
+  #undef CONNECTION_HANDLER_LOG_LEVEL
+  #define CONNECTION_HANDLER_LOG_LEVEL CONNECTION_HANDLER_LOG_LEVEL_NONE
+#elif !defined(CONNECTION_HANDLER_LOG_LEVEL)
+  #define CONNECTION_HANDLER_LOG_LEVEL CONNECTION_HANDLER_LOG_LEVEL_VERBOSE
+#endif
+
+/* Optional tokenized backend: when CONNECTION_HANDLER_LOG_TOKENIZED is defined,
+ * a message is written as a compact binary frame, carrying a 32 bit token
+ * (FNV-1a hash of the format string, computed at compile time) and the raw
+ * arguments, to the stream set with ConnectionHandlerLog::setOutput(). The
+ * format strings are not linked in, extras/tools/decode_log.py maps the
+ * tokens back to the messages of the library sources.
+ *
+ * Frame: 0xA5, level, payload length, token (4 bytes), payload. Integers are
+ * written as 4 bytes, strings as their length (1 byte) followed by their
+ * characters, everything little endian.
+ */
+#if defined(CONNECTION_HANDLER_LOG_TOKENIZED) && !defined(__AVR__)
+
+namespace ConnectionHandlerLog
+{
+  static uint8_t const FRAME_SYNC = 0xA5;
+  static size_t const FRAME_HEADER_SIZE = 7;
+  static size_t const FRAME_MAX_SIZE = 64;
+
+  constexpr uint32_t token(char const * str, uint32_t hash = 2166136261UL) {
+    return *str ? token(str + 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619UL) : hash;
+  }
+
+  /* The enum forces the token to be evaluated at compile time */
+  template <uint32_t TOKEN> struct Token {
+    enum : uint32_t { value = TOKEN };
+  };
+
+  inline Print * & output() {
+    static Print * out = nullptr;
+    return out;
+  }
+  inline void setOutput(Print & out) {
+    output() = &out;
+  }
+
+  class Frame
+  {
+    public:
+      Frame(uint8_t const level, uint32_t const token)
+      : _size{FRAME_HEADER_SIZE}
+      {
+        _buf[0] = FRAME_SYNC;
+        _buf[1] = level;
+        for (size_t i = 0; i < 4; i++)
+          _buf[3 + i] = (token >> (8 * i)) & 0xFF;
+      }
+
+      void add(long long const value) {
+        if ((_size + 4) > FRAME_MAX_SIZE)
+          return;
+        for (size_t i = 0; i < 4; i++)
+          _buf[_size++] = (static_cast<uint32_t>(value) >> (8 * i)) & 0xFF;
+      }
+      void add(int const value)                { add(static_cast<long long>(value)); }
+      void add(unsigned int const value)       { add(static_cast<long long>(value)); }
+      void add(long const value)               { add(static_cast<long long>(value)); }
+      void add(unsigned long const value)      { add(static_cast<long long>(value)); }
+      void add(unsigned long long const value) { add(static_cast<long long>(value)); }
+      void add(char const * const str) {
+        if ((_size + 1) > FRAME_MAX_SIZE)
+          return;
+        size_t const len_pos = _size++;
+        uint8_t len = 0;
+        for (char const * c = str; c && *c && _size < FRAME_MAX_SIZE; c++, len++)
+          _buf[_size++] = *c;
+        _buf[len_pos] = len;
+      }
+
+      void send(Print & out) {
+        _buf[2] = _size - FRAME_HEADER_SIZE;
+        out.write(_buf, _size);
+      }
+
+    private:
+      uint8_t _buf[FRAME_MAX_SIZE];
+      size_t _size;
+  };
+
+  inline void pack(Frame &) { }
+
+  template <typename T, typename... Args>
+  void pack(Frame & frame, T const & value, Args const &... args) {
+    frame.add(value);
+    pack(frame, args...);
+  }
+
+  template <typename... Args>
+  void log(int const level, uint32_t const token, Args const &... args) {
+    if (Print * out = output()) {
+      Frame frame(level, token);
+      pack(frame, args...);
+      frame.send(*out);
+    }
+  }
+} /* ConnectionHandlerLog */
+
+  #define CH_LOG_EMIT(level, fmt, ...) ConnectionHandlerLog::log(level, ConnectionHandlerLog::Token<ConnectionHandlerLog::token(fmt)>::value, ##__VA_ARGS__)
+#else
+  #define CH_LOG_EMIT(level, fmt, ...) Debug.print(level, F(fmt), ##__VA_ARGS__)
+#endif
+
+/* A disabled message is still type checked, but neither its arguments are
+ * evaluated nor its format string is emitted.
+ */
+#if defined(__AVR__)
+  #define CH_LOG_DISABLED(fmt, ...) do { } while (0)
+#else
+  #define CH_LOG_DISABLED(fmt, ...) do { if (false) { Debug.print(DBG_NONE, fmt, ##__VA_ARGS__); } } while (0)
+#endif
+
+#if CONNECTION_HANDLER_LOG_LEVEL >= CONNECTION_HANDLER_LOG_LEVEL_ERROR
+  #define CH_LOG_ERROR(fmt, ...) CH_LOG_EMIT(DBG_ERROR, fmt, ##__VA_ARGS__)
+#else
+  #define CH_LOG_ERROR(fmt, ...) CH_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if CONNECTION_HANDLER_LOG_LEVEL >= CONNECTION_HANDLER_LOG_LEVEL_WARNING
+  #define CH_LOG_WARNING(fmt, ...) CH_LOG_EMIT(DBG_WARNING, fmt, ##__VA_ARGS__)
+#else
+  #define CH_LOG_WARNING(fmt, ...) CH_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if CONNECTION_HANDLER_LOG_LEVEL >= CONNECTION_HANDLER_LOG_LEVEL_INFO
+  #define CH_LOG_INFO(fmt, ...) CH_LOG_EMIT(DBG_INFO, fmt, ##__VA_ARGS__)
+#else
+  #define CH_LOG_INFO(fmt, ...) CH_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if CONNECTION_HANDLER_LOG_LEVEL >= CONNECTION_HANDLER_LOG_LEVEL_DEBUG
+  #define CH_LOG_DEBUG(fmt, ...) CH_LOG_EMIT(DBG_DEBUG, fmt, ##__VA_ARGS__)
+#else
+  #define CH_LOG_DEBUG(fmt, ...) CH_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#if CONNECTION_HANDLER_LOG_LEVEL >= CONNECTION_HANDLER_LOG_LEVEL_VERBOSE
+  #define CH_LOG_VERBOSE(fmt, ...) CH_LOG_EMIT(DBG_VERBOSE, fmt, ##__VA_ARGS__)
+#else
+  #define CH_LOG_VERBOSE(fmt, ...) CH_LOG_DISABLED(fmt, ##__VA_ARGS__)
+#endif
+
+#endif /* ARDUINO_CONNECTION_HANDLER_LOG_H_ */
@@ -17,9 +17,17 @@
  ******************************************************************************/
 
 #include "Arduino_EthernetConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #ifdef BOARD_HAS_ETHERNET /* Only compile if the board has ethernet */
 
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static unsigned long const ETHERNET_TIMEOUT = 15000;
+static unsigned long const ETHERNET_RESPONSE_TIMEOUT = 4000;
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -30,6 +38,10 @@ EthernetConnectionHandler::EthernetConnectionHandler(bool const keep_alive)
 ,_dns{INADDR_NONE}
 ,_gateway{INADDR_NONE}
 ,_netmask{INADDR_NONE}
+,_timeout_ms{ETHERNET_TIMEOUT}
+,_response_timeout_ms{ETHERNET_RESPONSE_TIMEOUT}
+,_begin_attempted{false}
+,_link_down{false}
 {
 
 }
@@ -40,6 +52,10 @@ EthernetConnectionHandler::EthernetConnectionHandler(const IPAddress ip, const I
 ,_dns{dns}
 ,_gateway{gateway}
 ,_netmask{netmask}
+,_timeout_ms{ETHERNET_TIMEOUT}
+,_response_timeout_ms{ETHERNET_RESPONSE_TIMEOUT}
+,_begin_attempted{false}
+,_link_down{false}
 {
 
 }
@@ -50,6 +66,10 @@ EthernetConnectionHandler::EthernetConnectionHandler(const char * ip, const char
 ,_dns{INADDR_NONE}
 ,_gateway{INADDR_NONE}
 ,_netmask{INADDR_NONE}
+,_timeout_ms{ETHERNET_TIMEOUT}
+,_response_timeout_ms{ETHERNET_RESPONSE_TIMEOUT}
+,_begin_attempted{false}
+,_link_down{false}
 {
   if(!_ip.fromString(ip)) {
     _ip = INADDR_NONE;
@@ -72,7 +92,8 @@ EthernetConnectionHandler::EthernetConnectionHandler(const char * ip, const char
 NetworkConnectionState EthernetConnectionHandler::update_handleInit()
 {
   if (Ethernet.hardwareStatus() == EthernetNoHardware) {
-    Debug.print(DBG_ERROR, F("Error, ethernet shield was not found."));
+    CH_LOG_ERROR("Error, ethernet shield was not found.");
+    setTransitionReason(TransitionReason::HARDWARE_ERROR);
     return NetworkConnectionState::ERROR;
   }
   return NetworkConnectionState::CONNECTING;
@@ -80,14 +101,33 @@ NetworkConnectionState EthernetConnectionHandler::update_handleInit()
 
 NetworkConnectionState EthernetConnectionHandler::update_handleConnecting()
 {
+  /* There is no point in waiting for the configuration to time out if no
+   * cable is plugged in: check the link first and retry on the next tick.
+   * The link status is only reliable once begin() has initialized the
+   * interface (the W5100 and some mbed cores report it OFF until then).
+   */
+  if (_begin_attempted && Ethernet.linkStatus() == LinkOFF) {
+    if (!_link_down) {
+      CH_LOG_ERROR("Ethernet link OFF, check cable connection");
+      _link_down = true;
+    } else {
+      CH_LOG_DEBUG("Ethernet link still OFF");
+    }
+    return NetworkConnectionState::CONNECTING;
+  }
+  _link_down = false;
+  _begin_attempted = true;
+
   if (_ip != INADDR_NONE) {
-    if (Ethernet.begin(nullptr, _ip, _dns, _gateway, _netmask, 15000, 4000) == 0) {
-      Debug.print(DBG_ERROR, F("Failed to configure Ethernet, check cable connection"));
+    if (Ethernet.begin(nullptr, _ip, _dns, _gateway, _netmask, _timeout_ms, _response_timeout_ms) == 0) {
+      CH_LOG_ERROR("Failed to configure Ethernet, check cable connection");
+      connectionAttemptFailed();
       return NetworkConnectionState::CONNECTING;
     }
   } else {
-    if (Ethernet.begin(nullptr, 15000, 4000) == 0) {
-      Debug.print(DBG_ERROR, F("Waiting Ethernet configuration from DHCP server, check cable connection"));
+    if (Ethernet.begin(nullptr, _timeout_ms, _response_timeout_ms) == 0) {
+      CH_LOG_ERROR("Waiting Ethernet configuration from DHCP server, check cable connection");
+      connectionAttemptFailed();
       return NetworkConnectionState::CONNECTING;
     }
   }
@@ -98,11 +138,13 @@ NetworkConnectionState EthernetConnectionHandler::update_handleConnecting()
 NetworkConnectionState EthernetConnectionHandler::update_handleConnected()
 {
   if (Ethernet.linkStatus() == LinkOFF) {
-    Debug.print(DBG_ERROR, F("Ethernet link OFF, connection lost."));
+    CH_LOG_ERROR("Ethernet link OFF, connection lost.");
+    _link_down = true;
     if (_keep_alive)
     {
-      Debug.print(DBG_ERROR, F("Attempting reconnection"));
+      CH_LOG_ERROR("Attempting reconnection");
     }
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   return NetworkConnectionState::CONNECTED;
@@ -111,6 +153,7 @@ NetworkConnectionState EthernetConnectionHandler::update_handleConnected()
 NetworkConnectionState EthernetConnectionHandler::update_handleDisconnecting()
 {
   Ethernet.disconnect();
+  _begin_attempted = false;
   return NetworkConnectionState::DISCONNECTED;
 }
 
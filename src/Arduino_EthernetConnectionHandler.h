@@ -40,6 +40,15 @@ class EthernetConnectionHandler : public ConnectionHandler
     virtual Client & getClient() override{ return _eth_client; }
     virtual UDP & getUDP() override { return _eth_udp; }
 
+    /* Upper bound for the time a single check() may spend configuring the
+     * interface (DHCP lease or static configuration) and waiting for each
+     * response, before retrying on the following check().
+     */
+    void setConfigurationTimeout(unsigned long const timeout_ms, unsigned long const response_timeout_ms) {
+      _timeout_ms = timeout_ms;
+      _response_timeout_ms = response_timeout_ms;
+    }
+
 
   protected:
 
@@ -56,6 +65,11 @@ class EthernetConnectionHandler : public ConnectionHandler
     IPAddress _gateway;
     IPAddress _netmask;
 
+    unsigned long _timeout_ms;
+    unsigned long _response_timeout_ms;
+    bool _begin_attempted;
+    bool _link_down;
+
     EthernetUDP _eth_udp;
     EthernetClient _eth_client;
 
@@ -0,0 +1,238 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "Arduino_FailoverConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
+
+#if defined(BOARD_HAS_WIFI) || defined(BOARD_HAS_GSM) || defined(BOARD_HAS_NB) || defined(BOARD_HAS_ETHERNET) || defined(BOARD_HAS_CATM1_NBIOT) /* Only compile for IP based adapters */
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* The managed handlers are rate limited by their own check intervals, hence
+ * they can be polled often. The failover latency is therefore bounded by the
+ * CONNECTED check interval of the active handler plus a few of these ticks.
+ */
+static CheckIntervalTable const FAILOVER_CHECK_INTERVAL_TABLE =
+{{
+  /* INIT          */ 100,
+  /* CONNECTING    */ 100,
+  /* CONNECTED     */ 100,
+  /* DISCONNECTING */ 100,
+  /* DISCONNECTED  */ 100,
+  /* CLOSED        */ 1000,
+  /* ERROR         */ 1000
+}};
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+FailoverConnectionHandler::FailoverConnectionHandler(ConnectionHandler & primary, ConnectionHandler & secondary, uint32_t const failback_stable_ms, bool const keep_alive)
+: ConnectionHandler{keep_alive, primary.getInterface(), FAILOVER_CHECK_INTERVAL_TABLE}
+, _link_cnt{0}
+, _active{-1}
+, _failback_stable_ms{failback_stable_ms}
+, _links_shut_down{false}
+{
+  addHandler(primary, 0);
+  addHandler(secondary, 1);
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool FailoverConnectionHandler::addHandler(ConnectionHandler & handler, uint8_t const priority)
+{
+  if (_link_cnt >= MAX_HANDLERS)
+    return false;
+
+  /* Keep the links sorted by priority, the most preferred one first */
+  uint8_t pos = _link_cnt;
+  for (; pos > 0 && _links[pos - 1].priority > priority; pos--)
+    _links[pos] = _links[pos - 1];
+
+  _links[pos].handler = &handler;
+  _links[pos].state = NetworkConnectionState::INIT;
+  _links[pos].connected_since = 0;
+  _links[pos].priority = priority;
+  _link_cnt++;
+
+  if (_active >= pos)
+    _active++;
+
+  return true;
+}
+
+ConnectionHandler * FailoverConnectionHandler::getActiveHandler()
+{
+  return (_active < 0) ? nullptr : _links[_active].handler;
+}
+
+unsigned long FailoverConnectionHandler::getTime()
+{
+  return (_active < 0) ? 0 : _links[_active].handler->getTime();
+}
+
+Client & FailoverConnectionHandler::getClient()
+{
+  return activeOrPrimary().getClient();
+}
+
+UDP & FailoverConnectionHandler::getUDP()
+{
+  return activeOrPrimary().getUDP();
+}
+
+/******************************************************************************
+   PROTECTED MEMBER FUNCTIONS
+ ******************************************************************************/
+
+NetworkConnectionState FailoverConnectionHandler::update_handleInit()
+{
+  /* Restart the links which have been shut down by a previous disconnect().
+   * Their recorded state can't be relied upon: the links are not checked
+   * anymore once this handler is CLOSED, even if they are still going down.
+   */
+  if (_links_shut_down)
+  {
+    for (uint8_t i = 0; i < _link_cnt; i++)
+      _links[i].handler->connect();
+    _links_shut_down = false;
+  }
+  _active = -1;
+  return NetworkConnectionState::CONNECTING;
+}
+
+NetworkConnectionState FailoverConnectionHandler::update_handleConnecting()
+{
+  checkLinks();
+
+  int8_t const link = findConnectedLink(false);
+  if (link < 0)
+    return NetworkConnectionState::CONNECTING;
+
+  _active = link;
+  _interface = _links[link].handler->getInterface();
+  CH_LOG_INFO("Using connection with priority %d", _links[link].priority);
+  return NetworkConnectionState::CONNECTED;
+}
+
+NetworkConnectionState FailoverConnectionHandler::update_handleConnected()
+{
+  checkLinks();
+
+  if (_links[_active].state != NetworkConnectionState::CONNECTED)
+  {
+    CH_LOG_ERROR("Connection with priority %d lost.", _links[_active].priority);
+    if (_keep_alive)
+    {
+      CH_LOG_INFO("Failing over to the next available connection");
+    }
+    return NetworkConnectionState::DISCONNECTED;
+  }
+
+  /* Only fail back once the preferred link has proven to be stable */
+  int8_t const link = findConnectedLink(true);
+  if (link >= 0 && link < _active)
+  {
+    CH_LOG_INFO("Connection with priority %d is stable again, failing back", _links[link].priority);
+    return NetworkConnectionState::DISCONNECTED;
+  }
+
+  return NetworkConnectionState::CONNECTED;
+}
+
+NetworkConnectionState FailoverConnectionHandler::update_handleDisconnecting()
+{
+  bool all_disconnected = true;
+
+  if (!_links_shut_down)
+  {
+    for (uint8_t i = 0; i < _link_cnt; i++)
+      _links[i].handler->disconnect();
+    _links_shut_down = true;
+  }
+  checkLinks();
+  for (uint8_t i = 0; i < _link_cnt; i++)
+  {
+    if (_links[i].state == NetworkConnectionState::DISCONNECTING)
+      all_disconnected = false;
+  }
+
+  _active = -1;
+  return all_disconnected ? NetworkConnectionState::DISCONNECTED : NetworkConnectionState::DISCONNECTING;
+}
+
+NetworkConnectionState FailoverConnectionHandler::update_handleDisconnected()
+{
+  checkLinks();
+
+  if (_keep_alive)
+  {
+    return NetworkConnectionState::INIT;
+  }
+  else
+  {
+    return NetworkConnectionState::CLOSED;
+  }
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void FailoverConnectionHandler::checkLinks()
+{
+  unsigned long const now = millis();
+
+  for (uint8_t i = 0; i < _link_cnt; i++)
+  {
+    NetworkConnectionState const state = _links[i].handler->check();
+    if (state == NetworkConnectionState::CONNECTED && _links[i].state != NetworkConnectionState::CONNECTED)
+      _links[i].connected_since = now;
+    _links[i].state = state;
+  }
+}
+
+int8_t FailoverConnectionHandler::findConnectedLink(bool const stable) const
+{
+  unsigned long const now = millis();
+
+  for (uint8_t i = 0; i < _link_cnt; i++)
+  {
+    if (_links[i].state != NetworkConnectionState::CONNECTED)
+      continue;
+    if (stable && (now - _links[i].connected_since) < _failback_stable_ms)
+      continue;
+    return i;
+  }
+  return -1;
+}
+
+ConnectionHandler & FailoverConnectionHandler::activeOrPrimary()
+{
+  return *_links[(_active < 0) ? 0 : _active].handler;
+}
+
+#endif /* #if defined(BOARD_HAS_WIFI) || ... */
@@ -0,0 +1,88 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_FAILOVER_CONNECTION_HANDLER_H_
+#define ARDUINO_FAILOVER_CONNECTION_HANDLER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "Arduino_ConnectionHandler.h"
+
+#if defined(BOARD_HAS_WIFI) || defined(BOARD_HAS_GSM) || defined(BOARD_HAS_NB) || defined(BOARD_HAS_ETHERNET) || defined(BOARD_HAS_CATM1_NBIOT) /* Only compile for IP based adapters */
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Manages several connection handlers at once (e.g. Ethernet and WiFi) and
+ * exposes the Client/UDP of the best link currently connected. Priority 0 is
+ * the most preferred one. Whenever the active link is lost, or a more
+ * preferred link has been connected for at least failback_stable_ms, the
+ * handler goes through DISCONNECTED and then CONNECTED again on the new link,
+ * so that the application can re-open its connections.
+ */
+class FailoverConnectionHandler : public ConnectionHandler
+{
+  public:
+
+    static uint8_t const MAX_HANDLERS = 4;
+
+    FailoverConnectionHandler(ConnectionHandler & primary, ConnectionHandler & secondary, uint32_t const failback_stable_ms = 60000, bool const keep_alive = true);
+
+    bool addHandler(ConnectionHandler & handler, uint8_t const priority);
+    ConnectionHandler * getActiveHandler();
+
+    virtual unsigned long getTime() override;
+    virtual Client & getClient() override;
+    virtual UDP & getUDP() override;
+
+
+  protected:
+
+    virtual NetworkConnectionState update_handleInit         () override;
+    virtual NetworkConnectionState update_handleConnecting   () override;
+    virtual NetworkConnectionState update_handleConnected    () override;
+    virtual NetworkConnectionState update_handleDisconnecting() override;
+    virtual NetworkConnectionState update_handleDisconnected () override;
+
+
+  private:
+
+    struct Link
+    {
+      ConnectionHandler * handler;
+      NetworkConnectionState state;
+      unsigned long connected_since;
+      uint8_t priority;
+    };
+
+    Link _links[MAX_HANDLERS];
+    uint8_t _link_cnt;
+    int8_t _active;
+    uint32_t _failback_stable_ms;
+    bool _links_shut_down;
+
+    void checkLinks();
+    int8_t findConnectedLink(bool const stable) const;
+    ConnectionHandler & activeOrPrimary();
+};
+
+#endif /* #if defined(BOARD_HAS_WIFI) || ... */
+
+#endif /* ARDUINO_FAILOVER_CONNECTION_HANDLER_H_ */
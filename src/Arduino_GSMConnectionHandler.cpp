@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "Arduino_GSMConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #ifdef BOARD_HAS_GSM /* Only compile if this is a board with GSM */
 
@@ -27,8 +28,10 @@
    CONSTANTS
  ******************************************************************************/
 
-static int const GSM_TIMEOUT = 30000;
-static int const GPRS_TIMEOUT = 30000;
+static unsigned long const GSM_TIMEOUT = 30000;
+static unsigned long const GPRS_TIMEOUT = 30000;
+/* begin() includes the network registration, which may take minutes */
+static unsigned long const GSM_REGISTRATION_TIMEOUT = 180000;
 
 /******************************************************************************
    FUNCTION DEFINITION
@@ -52,6 +55,11 @@ GSMConnectionHandler::GSMConnectionHandler(const char * pin, const char * apn, c
 , _apn(apn)
 , _login(login)
 , _pass(pass)
+, _init_step(InitStep::BEGIN)
+, _init_step_ms(0)
+, _sim_unlock_duration_ms(0)
+, _gprs_attach_duration_ms(0)
+, _ping_duration_ms(0)
 {
 
 }
@@ -62,7 +70,12 @@ GSMConnectionHandler::GSMConnectionHandler(const char * pin, const char * apn, c
 
 unsigned long GSMConnectionHandler::getTime()
 {
-  return _gsm.getTime();
+  unsigned long time = getCachedTime();
+  if (!time) {
+    time = _gsm.getTime();
+    updateTimeCache(time);
+  }
+  return time;
 }
 
 /******************************************************************************
@@ -73,46 +86,101 @@ NetworkConnectionState GSMConnectionHandler::update_handleInit()
 {
   mkr_gsm_feed_watchdog();
 
-  if (_gsm.begin(_pin) != GSM_READY)
-  {
-    Debug.print(DBG_ERROR, F("SIM not present or wrong PIN"));
-    return NetworkConnectionState::ERROR;
-  }
-
-  mkr_gsm_feed_watchdog();
-
-  Debug.print(DBG_INFO, F("SIM card ok"));
-  _gsm.setTimeout(GSM_TIMEOUT);
-  _gprs.setTimeout(GPRS_TIMEOUT);
-
-  mkr_gsm_feed_watchdog();
-
-  GSM3_NetworkStatus_t const network_status = _gprs.attachGPRS(_apn, _login, _pass, true);
-  Debug.print(DBG_DEBUG, F("GPRS.attachGPRS(): %d"), network_status);
-  if (network_status == GSM3_NetworkStatus_t::ERROR)
+  /* The modem is driven in asynchronous mode: every step is started once and
+   * its completion is polled on the following calls to check().
+   */
+  switch (_init_step)
   {
-    Debug.print(DBG_ERROR, F("GPRS attach failed"));
-    Debug.print(DBG_ERROR, F("Make sure the antenna is connected and reset your board."));
-    return NetworkConnectionState::ERROR;
+    case InitStep::BEGIN:
+    {
+      _gsm.begin(_pin, true, false);
+      _init_step = InitStep::SIM_UNLOCK;
+      _init_step_ms = millis();
+    }
+    break;
+
+    case InitStep::SIM_UNLOCK:
+    {
+      int const ready = _gsm.ready();
+      _sim_unlock_duration_ms = millis() - _init_step_ms;
+      if (ready == 0)
+      {
+        if (_sim_unlock_duration_ms >= GSM_REGISTRATION_TIMEOUT)
+        {
+          CH_LOG_ERROR("Network registration timed out, retrying");
+          _init_step = InitStep::BEGIN;
+          connectionAttemptFailed();
+        }
+        break;
+      }
+
+      if (ready != 1)
+      {
+        CH_LOG_ERROR("SIM not present or wrong PIN");
+        _init_step = InitStep::BEGIN;
+        setTransitionReason(TransitionReason::AUTH_FAILED);
+        return NetworkConnectionState::ERROR;
+      }
+
+      CH_LOG_INFO("SIM card ok");
+      CH_LOG_DEBUG("SIM unlock took %lu milliseconds", _sim_unlock_duration_ms);
+      _gsm.setTimeout(GSM_TIMEOUT);
+      _gprs.setTimeout(GPRS_TIMEOUT);
+
+      _gprs.attachGPRS(_apn, _login, _pass, false);
+      _init_step = InitStep::GPRS_ATTACH;
+      _init_step_ms = millis();
+    }
+    break;
+
+    case InitStep::GPRS_ATTACH:
+    {
+      int const ready = _gprs.ready();
+      _gprs_attach_duration_ms = millis() - _init_step_ms;
+      if (ready == 0)
+      {
+        if (_gprs_attach_duration_ms >= GPRS_TIMEOUT)
+        {
+          CH_LOG_ERROR("GPRS.attachGPRS() timed out, retrying");
+          _init_step = InitStep::BEGIN;
+          connectionAttemptFailed();
+        }
+        break;
+      }
+
+      _init_step = InitStep::BEGIN;
+      CH_LOG_DEBUG("GPRS.attachGPRS(): %d after %lu milliseconds", ready, _gprs_attach_duration_ms);
+      if (ready != 1)
+      {
+        CH_LOG_ERROR("GPRS attach failed");
+        CH_LOG_ERROR("Make sure the antenna is connected and reset your board.");
+        setTransitionReason(TransitionReason::ATTACH_FAILED);
+        return NetworkConnectionState::ERROR;
+      }
+      return NetworkConnectionState::CONNECTING;
+    }
   }
 
-  return NetworkConnectionState::CONNECTING;
+  return NetworkConnectionState::INIT;
 }
 
 NetworkConnectionState GSMConnectionHandler::update_handleConnecting()
 {
-  Debug.print(DBG_INFO, F("Sending PING to outer space..."));
+  CH_LOG_INFO("Sending PING to outer space...");
+  unsigned long const start_ms = millis();
   int const ping_result = _gprs.ping("time.arduino.cc");
-  Debug.print(DBG_INFO, F("GPRS.ping(): %d"), ping_result);
+  _ping_duration_ms = millis() - start_ms;
+  CH_LOG_INFO("GPRS.ping(): %d", ping_result);
   if (ping_result < 0)
   {
-    Debug.print(DBG_ERROR, F("PING failed"));
-    Debug.print(DBG_INFO, F("Retrying in  \"%d\" milliseconds"), CHECK_INTERVAL_TABLE[static_cast<unsigned int>(NetworkConnectionState::CONNECTING)]);
+    CH_LOG_ERROR("PING failed");
+    CH_LOG_INFO("Retrying in  \"%d\" milliseconds", getCheckInterval(NetworkConnectionState::CONNECTING));
+    connectionAttemptFailed();
     return NetworkConnectionState::CONNECTING;
   }
   else
   {
-    Debug.print(DBG_INFO, F("Connected to GPRS Network"));
+    CH_LOG_INFO("Connected to GPRS Network");
     return NetworkConnectionState::CONNECTED;
   }
 }
@@ -122,6 +190,7 @@ NetworkConnectionState GSMConnectionHandler::update_handleConnected()
   int const is_gsm_access_alive = _gsm.isAccessAlive();
   if (is_gsm_access_alive != 1)
   {
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   return NetworkConnectionState::CONNECTED;
@@ -129,6 +198,7 @@ NetworkConnectionState GSMConnectionHandler::update_handleConnected()
 
 NetworkConnectionState GSMConnectionHandler::update_handleDisconnecting()
 {
+  _init_step = InitStep::BEGIN;
   _gsm.shutdown();
   return NetworkConnectionState::DISCONNECTED;
 }
@@ -42,6 +42,11 @@ class GSMConnectionHandler : public ConnectionHandler
     virtual Client & getClient() override { return _gsm_client; };
     virtual UDP & getUDP() override { return _gsm_udp; };
 
+    /* Time spent in each step of the last connection attempt */
+    unsigned long getSimUnlockDuration() const { return _sim_unlock_duration_ms; }
+    unsigned long getGprsAttachDuration() const { return _gprs_attach_duration_ms; }
+    unsigned long getPingDuration() const { return _ping_duration_ms; }
+
 
   protected:
 
@@ -54,6 +59,13 @@ class GSMConnectionHandler : public ConnectionHandler
 
   private:
 
+    enum class InitStep
+    {
+      BEGIN,
+      SIM_UNLOCK,
+      GPRS_ATTACH
+    };
+
     const char * _pin;
     const char * _apn;
     const char * _login;
@@ -63,6 +75,12 @@ class GSMConnectionHandler : public ConnectionHandler
     GPRS _gprs;
     GSMUDP _gsm_udp;
     GSMClient _gsm_client;
+
+    InitStep _init_step;
+    unsigned long _init_step_ms;
+    unsigned long _sim_unlock_duration_ms;
+    unsigned long _gprs_attach_duration_ms;
+    unsigned long _ping_duration_ms;
 };
 
 #endif /* #ifdef BOARD_HAS_GSM  */
@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "Arduino_LoRaConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #if defined(BOARD_HAS_LORA) /* Only compile if the board has LoRa */
 
@@ -40,6 +41,14 @@ typedef enum
   LORA_ERROR_MAX_PACKET_SIZE      = -20
 } LoRaCommunicationError;
 
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* Time the chip needs after begin() and configureClass() before joining */
+static unsigned long const LORA_INIT_SETTLE_TIME = 100;
+static uint32_t const LORA_JOIN_TIMEOUT = 60000;
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -50,6 +59,10 @@ LoRaConnectionHandler::LoRaConnectionHandler(char const * appeui, char const * a
 , _band(band)
 , _channelMask(channelMask)
 , _device_class(device_class)
+, _init_step(InitStep::BEGIN)
+, _init_step_ms(0)
+, _join_timeout_ms(LORA_JOIN_TIMEOUT)
+, _last_join_duration_ms(0)
 {
 
 }
@@ -68,20 +81,20 @@ int LoRaConnectionHandler::write(const uint8_t * buf, size_t size)
   {
     switch (err)
     {
-      case LoRaCommunicationError::LORA_ERROR_ACK_NOT_RECEIVED:     Debug.print(DBG_ERROR, F("Message ack was not received, the message could not be delivered")); break;
-      case LoRaCommunicationError::LORA_ERROR_GENERIC:              Debug.print(DBG_ERROR, F("LoRa generic error (LORA_ERROR)"));                                  break;
-      case LoRaCommunicationError::LORA_ERROR_WRONG_PARAM:          Debug.print(DBG_ERROR, F("LoRa malformed param error (LORA_ERROR_PARAM"));                     break;
-      case LoRaCommunicationError::LORA_ERROR_COMMUNICATION_BUSY:   Debug.print(DBG_ERROR, F("LoRa chip is busy (LORA_ERROR_BUSY)"));                              break;
-      case LoRaCommunicationError::LORA_ERROR_MESSAGE_OVERFLOW:     Debug.print(DBG_ERROR, F("LoRa chip overflow error (LORA_ERROR_OVERFLOW)"));                   break;
-      case LoRaCommunicationError::LORA_ERROR_NO_NETWORK_AVAILABLE: Debug.print(DBG_ERROR, F("LoRa no network error (LORA_ERROR_NO_NETWORK)"));                    break;
-      case LoRaCommunicationError::LORA_ERROR_RX_PACKET:            Debug.print(DBG_ERROR, F("LoRa rx error (LORA_ERROR_RX)"));                                    break;
-      case LoRaCommunicationError::LORA_ERROR_REASON_UNKNOWN:       Debug.print(DBG_ERROR, F("LoRa unknown error (LORA_ERROR_UNKNOWN)"));                          break;
-      case LoRaCommunicationError::LORA_ERROR_MAX_PACKET_SIZE:      Debug.print(DBG_ERROR, F("Message length is bigger than max LoRa packet!"));                   break;
+      case LoRaCommunicationError::LORA_ERROR_ACK_NOT_RECEIVED:     CH_LOG_ERROR("Message ack was not received, the message could not be delivered"); break;
+      case LoRaCommunicationError::LORA_ERROR_GENERIC:              CH_LOG_ERROR("LoRa generic error (LORA_ERROR)");                                  break;
+      case LoRaCommunicationError::LORA_ERROR_WRONG_PARAM:          CH_LOG_ERROR("LoRa malformed param error (LORA_ERROR_PARAM");                     break;
+      case LoRaCommunicationError::LORA_ERROR_COMMUNICATION_BUSY:   CH_LOG_ERROR("LoRa chip is busy (LORA_ERROR_BUSY)");                              break;
+      case LoRaCommunicationError::LORA_ERROR_MESSAGE_OVERFLOW:     CH_LOG_ERROR("LoRa chip overflow error (LORA_ERROR_OVERFLOW)");                   break;
+      case LoRaCommunicationError::LORA_ERROR_NO_NETWORK_AVAILABLE: CH_LOG_ERROR("LoRa no network error (LORA_ERROR_NO_NETWORK)");                    break;
+      case LoRaCommunicationError::LORA_ERROR_RX_PACKET:            CH_LOG_ERROR("LoRa rx error (LORA_ERROR_RX)");                                    break;
+      case LoRaCommunicationError::LORA_ERROR_REASON_UNKNOWN:       CH_LOG_ERROR("LoRa unknown error (LORA_ERROR_UNKNOWN)");                          break;
+      case LoRaCommunicationError::LORA_ERROR_MAX_PACKET_SIZE:      CH_LOG_ERROR("Message length is bigger than max LoRa packet!");                   break;
     }
   }
   else
   {
-    Debug.print(DBG_INFO, F("Message sent correctly!"));
+    CH_LOG_INFO("Message sent correctly!");
   }
   return err;
 }
@@ -96,41 +109,90 @@ bool LoRaConnectionHandler::available()
   return _modem.available();
 }
 
+int LoRaConnectionHandler::read(uint8_t * buf, size_t len)
+{
+  int const size = _modem.available();
+  int const count = (size < static_cast<int>(len)) ? size : static_cast<int>(len);
+  for (int i = 0; i < count; i++) {
+    buf[i] = _modem.read();
+  }
+  return count;
+}
+
+int LoRaConnectionHandler::peek()
+{
+  return _modem.peek();
+}
+
+size_t LoRaConnectionHandler::payloadSize()
+{
+  return _modem.available();
+}
+
 /******************************************************************************
    PROTECTED MEMBER FUNCTIONS
  ******************************************************************************/
 
 NetworkConnectionState LoRaConnectionHandler::update_handleInit()
 {
-  if (!_modem.begin(_band))
+  /* The initialization is split in steps, so that the time the chip needs to
+   * settle in between them is spent in between calls to check() instead of
+   * in a delay().
+   */
+  switch (_init_step)
   {
-    Debug.print(DBG_ERROR, F("Something went wrong; are you indoor? Move near a window, then reset and retry."));
-    return NetworkConnectionState::ERROR;
+    case InitStep::BEGIN:
+      if (!_modem.begin(_band))
+      {
+        CH_LOG_ERROR("Something went wrong; are you indoor? Move near a window, then reset and retry.");
+        setTransitionReason(TransitionReason::HARDWARE_ERROR);
+        return NetworkConnectionState::ERROR;
+      }
+      // Set channelmask based on configuration
+      if (_channelMask) {
+        _modem.sendMask(_channelMask);
+      }
+      _init_step = InitStep::CONFIGURE_CLASS;
+      _init_step_ms = millis();
+      break;
+
+    case InitStep::CONFIGURE_CLASS:
+      if ((millis() - _init_step_ms) < LORA_INIT_SETTLE_TIME)
+        break;
+      _modem.configureClass(_device_class);
+      _init_step = InitStep::SETTLE;
+      _init_step_ms = millis();
+      break;
+
+    case InitStep::SETTLE:
+      if ((millis() - _init_step_ms) < LORA_INIT_SETTLE_TIME)
+        break;
+      _init_step = InitStep::BEGIN;
+      CH_LOG_INFO("Connecting to the network");
+      return NetworkConnectionState::CONNECTING;
   }
-  // Set channelmask based on configuration
-  if (_channelMask) {
-    _modem.sendMask(_channelMask);
-  }
-  //A delay is required between _modem.begin(band) and _modem.joinOTAA(appeui, appkey) in order to let the chip to be correctly initialized before the connection attempt
-  delay(100);
-  _modem.configureClass(_device_class);
-  delay(100);
-  Debug.print(DBG_INFO, F("Connecting to the network"));
-  return NetworkConnectionState::CONNECTING;
+
+  return NetworkConnectionState::INIT;
 }
 
 NetworkConnectionState LoRaConnectionHandler::update_handleConnecting()
 {
-  bool const network_status = _modem.joinOTAA(_appeui, _appkey);
+  unsigned long const start_ms = millis();
+  bool const network_status = _modem.joinOTAA(_appeui, _appkey, NULL, _join_timeout_ms);
+  _last_join_duration_ms = millis() - start_ms;
+  CH_LOG_DEBUG("LoRa join attempt took %d milliseconds", _last_join_duration_ms);
+
   if (network_status != true)
   {
-    Debug.print(DBG_ERROR, F("Connection to the network failed"));
-    Debug.print(DBG_INFO, F("Retrying in \"%d\" milliseconds"), CHECK_INTERVAL_TABLE[static_cast<unsigned int>(NetworkConnectionState::CONNECTING)]);
-    return NetworkConnectionState::INIT;
+    /* The modem is still initialized, hence only the join needs to be retried */
+    CH_LOG_ERROR("Connection to the network failed");
+    CH_LOG_INFO("Retrying in \"%d\" milliseconds", getCheckInterval(NetworkConnectionState::CONNECTING));
+    connectionAttemptFailed();
+    return NetworkConnectionState::CONNECTING;
   }
   else
   {
-    Debug.print(DBG_INFO, F("Connected to the network"));
+    CH_LOG_INFO("Connected to the network");
     return NetworkConnectionState::CONNECTED;
   }
 }
@@ -140,11 +202,12 @@ NetworkConnectionState LoRaConnectionHandler::update_handleConnected()
   bool const network_status = _modem.connected();
   if (network_status != true)
   {
-    Debug.print(DBG_ERROR, F("Connection to the network lost."));
+    CH_LOG_ERROR("Connection to the network lost.");
     if (_keep_alive)
     {
-      Debug.print(DBG_ERROR, F("Attempting reconnection"));
+      CH_LOG_ERROR("Attempting reconnection");
     }
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   return NetworkConnectionState::CONNECTED;
@@ -152,10 +215,11 @@ NetworkConnectionState LoRaConnectionHandler::update_handleConnected()
 
 NetworkConnectionState LoRaConnectionHandler::update_handleDisconnecting()
 {
-  Debug.print(DBG_ERROR, F("Connection to the network lost."));
+  _init_step = InitStep::BEGIN;
+  CH_LOG_ERROR("Connection to the network lost.");
   if (_keep_alive)
   {
-    Debug.print(DBG_ERROR, F("Attempting reconnection"));
+    CH_LOG_ERROR("Attempting reconnection");
   }
   return NetworkConnectionState::DISCONNECTED;
 }
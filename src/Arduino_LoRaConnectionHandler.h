@@ -39,6 +39,9 @@ class LoRaConnectionHandler : public ConnectionHandler
     virtual int write(const uint8_t *buf, size_t size) override;
     virtual int read() override;
     virtual bool available() override;
+    virtual int read(uint8_t *buf, size_t len) override;
+    virtual int peek() override;
+    virtual size_t payloadSize() override;
 
     inline String getVersion() { return _modem.version(); }
     inline String getDeviceEUI() { return _modem.deviceEUI(); }
@@ -55,6 +58,11 @@ class LoRaConnectionHandler : public ConnectionHandler
     inline int32_t getFCU() { return _modem.getFCU(); }
     inline int32_t getFCD() { return _modem.getFCD(); }
 
+    /* Upper bound for the time a single OTAA join attempt may block check() */
+    inline void setJoinTimeout(uint32_t const timeout_ms) { _join_timeout_ms = timeout_ms; }
+    /* Time spent in the last OTAA join attempt */
+    inline unsigned long getLastJoinDuration() const { return _last_join_duration_ms; }
+
   protected:
 
     virtual NetworkConnectionState update_handleInit         () override;
@@ -66,12 +74,23 @@ class LoRaConnectionHandler : public ConnectionHandler
 
   private:
 
+    enum class InitStep
+    {
+      BEGIN,
+      CONFIGURE_CLASS,
+      SETTLE
+    };
+
     char const * _appeui;
     char const * _appkey;
     _lora_band _band;
     char const * _channelMask;
     _lora_class _device_class;
     LoRaModem _modem;
+    InitStep _init_step;
+    unsigned long _init_step_ms;
+    uint32_t _join_timeout_ms;
+    unsigned long _last_join_duration_ms;
 };
 
 #endif /* #ifdef BOARD_HAS_LORA */
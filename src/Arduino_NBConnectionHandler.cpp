@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "Arduino_NBConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #ifdef BOARD_HAS_NB /* Only compile if this is a board with NB */
 
@@ -28,6 +29,8 @@
  ******************************************************************************/
 
 static int const NB_TIMEOUT = 30000;
+static unsigned long const NB_REGISTRATION_TIMEOUT = 180000;
+static unsigned long const NB_GPRS_ATTACH_TIMEOUT = 60000;
 
 /******************************************************************************
    FUNCTION DEFINITION
@@ -62,6 +65,12 @@ NBConnectionHandler::NBConnectionHandler(char const * pin, char const * apn, cha
 , _apn(apn)
 , _login(login)
 , _pass(pass)
+, _step_pending(false)
+, _step_start_ms(0)
+, _registration_timeout_ms(NB_REGISTRATION_TIMEOUT)
+, _gprs_attach_timeout_ms(NB_GPRS_ATTACH_TIMEOUT)
+, _registration_duration_ms(0)
+, _gprs_attach_duration_ms(0)
 {
 
 }
@@ -72,7 +81,12 @@ NBConnectionHandler::NBConnectionHandler(char const * pin, char const * apn, cha
 
 unsigned long NBConnectionHandler::getTime()
 {
-  return _nb.getTime();
+  unsigned long time = getCachedTime();
+  if (!time) {
+    time = _nb.getTime();
+    updateTimeCache(time);
+  }
+  return time;
 }
 
 /******************************************************************************
@@ -83,31 +97,81 @@ NetworkConnectionState NBConnectionHandler::update_handleInit()
 {
   mkr_nb_feed_watchdog();
 
-  if (_nb.begin(_pin, _apn, _login, _pass) == NB_READY)
+  /* Start the SIM unlock and network registration in asynchronous mode and
+   * poll for its completion on the following calls to check().
+   */
+  if (!_step_pending)
+  {
+    _nb.begin(_pin, _apn, _login, _pass, true, false);
+    _step_pending = true;
+    _step_start_ms = millis();
+    return NetworkConnectionState::INIT;
+  }
+
+  int const ready = _nb.ready();
+  _registration_duration_ms = millis() - _step_start_ms;
+  if (ready == 0)
+  {
+    if (_registration_duration_ms > _registration_timeout_ms)
+    {
+      CH_LOG_ERROR("Network registration timed out, retrying");
+      _step_pending = false;
+      connectionAttemptFailed();
+    }
+    return NetworkConnectionState::INIT;
+  }
+
+  _step_pending = false;
+  if (ready == 1)
   {
-    Debug.print(DBG_INFO, F("SIM card ok"));
+    CH_LOG_INFO("SIM card ok");
+    CH_LOG_DEBUG("Network registration took %lu milliseconds", _registration_duration_ms);
     _nb.setTimeout(NB_TIMEOUT);
     return NetworkConnectionState::CONNECTING;
   }
   else
   {
-    Debug.print(DBG_ERROR, F("SIM not present or wrong PIN"));
+    CH_LOG_ERROR("SIM not present or wrong PIN");
+    setTransitionReason(TransitionReason::AUTH_FAILED);
     return NetworkConnectionState::ERROR;
   }
 }
 
 NetworkConnectionState NBConnectionHandler::update_handleConnecting()
 {
-  NB_NetworkStatus_t const network_status = _nb_gprs.attachGPRS(true);
-  Debug.print(DBG_DEBUG, F("GPRS.attachGPRS(): %d"), network_status);
-  if (network_status == NB_NetworkStatus_t::NB_ERROR)
+  /* Activate the PDP context in asynchronous mode and poll for its completion */
+  if (!_step_pending)
+  {
+    _nb_gprs.attachGPRS(false);
+    _step_pending = true;
+    _step_start_ms = millis();
+    return NetworkConnectionState::CONNECTING;
+  }
+
+  int const ready = _nb_gprs.ready();
+  _gprs_attach_duration_ms = millis() - _step_start_ms;
+  if (ready == 0)
+  {
+    if (_gprs_attach_duration_ms > _gprs_attach_timeout_ms)
+    {
+      CH_LOG_ERROR("GPRS.attachGPRS() timed out, retrying");
+      _step_pending = false;
+      connectionAttemptFailed();
+    }
+    return NetworkConnectionState::CONNECTING;
+  }
+
+  _step_pending = false;
+  CH_LOG_DEBUG("GPRS.attachGPRS(): %d after %lu milliseconds", ready, _gprs_attach_duration_ms);
+  if (ready != 1)
   {
-    Debug.print(DBG_ERROR, F("GPRS.attachGPRS() failed"));
+    CH_LOG_ERROR("GPRS.attachGPRS() failed");
+    setTransitionReason(TransitionReason::ATTACH_FAILED);
     return NetworkConnectionState::ERROR;
   }
   else
   {
-    Debug.print(DBG_INFO, F("Connected to GPRS Network"));
+    CH_LOG_INFO("Connected to GPRS Network");
     return NetworkConnectionState::CONNECTED;
   }
 }
@@ -115,22 +179,24 @@ NetworkConnectionState NBConnectionHandler::update_handleConnecting()
 NetworkConnectionState NBConnectionHandler::update_handleConnected()
 {
   int const nb_is_access_alive = _nb.isAccessAlive();
-  Debug.print(DBG_VERBOSE, F("GPRS.isAccessAlive(): %d"), nb_is_access_alive);
+  CH_LOG_VERBOSE("GPRS.isAccessAlive(): %d", nb_is_access_alive);
   if (nb_is_access_alive != 1)
   {
-    Debug.print(DBG_INFO, F("Disconnected from cellular network"));
+    CH_LOG_INFO("Disconnected from cellular network");
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   else
   {
-    Debug.print(DBG_VERBOSE, F("Connected to Cellular Network"));
+    CH_LOG_VERBOSE("Connected to Cellular Network");
     return NetworkConnectionState::CONNECTED;
   }
 }
 
 NetworkConnectionState NBConnectionHandler::update_handleDisconnecting()
 {
-  Debug.print(DBG_VERBOSE, F("Disconnecting from Cellular Network"));
+  CH_LOG_VERBOSE("Disconnecting from Cellular Network");
+  _step_pending = false;
   _nb.shutdown();
   return NetworkConnectionState::DISCONNECTED;
 }
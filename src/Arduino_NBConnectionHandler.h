@@ -43,6 +43,17 @@ class NBConnectionHandler : public ConnectionHandler
     virtual Client & getClient() override { return _nb_client; };
     virtual UDP & getUDP() override { return _nb_udp; };
 
+    /* Deadlines for the network registration (including the SIM unlock) and for
+     * the PDP context activation, after which the step is started over.
+     */
+    void setAttachTimeouts(unsigned long const registration_timeout_ms, unsigned long const gprs_attach_timeout_ms) {
+      _registration_timeout_ms = registration_timeout_ms;
+      _gprs_attach_timeout_ms = gprs_attach_timeout_ms;
+    }
+    /* Time spent in each step of the last connection attempt */
+    unsigned long getRegistrationDuration() const { return _registration_duration_ms; }
+    unsigned long getGprsAttachDuration() const { return _gprs_attach_duration_ms; }
+
 
   protected:
 
@@ -66,6 +77,13 @@ class NBConnectionHandler : public ConnectionHandler
     GPRS _nb_gprs;
     NBUDP _nb_udp;
     NBClient _nb_client;
+
+    bool _step_pending;
+    unsigned long _step_start_ms;
+    unsigned long _registration_timeout_ms;
+    unsigned long _gprs_attach_timeout_ms;
+    unsigned long _registration_duration_ms;
+    unsigned long _gprs_attach_duration_ms;
 };
 
 #endif /* #ifdef BOARD_HAS_NB  */
@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "Arduino_NotecardConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #if defined(USE_NOTECARD) /* Only compile if the Notecard is present */
 
@@ -37,6 +38,17 @@
 #define NOTEFILE_SSL_INBOUND NOTEFILE_BASE_NAME ".qis"
 #define NOTEFILE_SSL_OUTBOUND NOTEFILE_BASE_NAME ".qos"
 
+// Binary payloads are staged in the Notecard binary buffer in chunks of up to
+// NOTECARD_BINARY_CHUNK_SIZE bytes, one `card.binary.put` transaction each.
+// Each chunk is COBS encoded in place, so the staging buffer reserves room for
+// the encoding overhead (1 byte every 254, plus the code and newline bytes).
+#define NOTECARD_BINARY_CHUNK_SIZE 4096
+#define NOTECARD_BINARY_STAGING_SIZE(chunk_size) ((chunk_size) + ((chunk_size) / 254) + 4)
+
+// A failed `hub.set` is retried on subsequent calls to `check()` (instead of
+// blocking in `requestAndResponseWithRetry()`) until this timeout is exceeded
+#define HUB_SET_RETRY_TIMEOUT_MS 30000
+
 /******************************************************************************
    STLINK DEBUG OUTPUT
  ******************************************************************************/
@@ -47,7 +59,7 @@
 
   void logMemoryUsage (const char *ctx_, bool enter_ = false) {
     struct mallinfo mi = mallinfo();
-    Debug.print(DBG_DEBUG, F("[MEMORY][%s %s] Allocated: %d bytes"), (enter_ ? ">>>>" : "<<<<"), ctx_, mi.uordblks);
+    CH_LOG_DEBUG("[MEMORY][%s %s] Allocated: %d bytes", (enter_ ? ">>>>" : "<<<<"), ctx_, mi.uordblks);
   }
 #endif
 #if defined(ARDUINO_SWAN_R5)
@@ -83,6 +95,12 @@ struct NotecardConnectionStatus
 };
 static_assert(sizeof(NotecardConnectionStatus) == sizeof(uint_fast8_t));
 
+/******************************************************************************
+   STATIC MEMBER DECLARATION
+ ******************************************************************************/
+
+NotecardConnectionHandler * volatile NotecardConnectionHandler::_attn_instance = nullptr;
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -94,19 +112,39 @@ NotecardConnectionHandler::NotecardConnectionHandler(
   uint32_t i2c_address,
   uint32_t i2c_max,
   TwoWire & wire,
-  const String & notehub_url
+  const String & notehub_url,
+  uint32_t inbound_buffer_capacity
 ) :
   ConnectionHandler{keep_alive, NetworkAdapter::NOTECARD},
   _serial(nullptr),
   _wire(&wire),
   _inbound_buffer(nullptr),
+  _binary_buffer(nullptr),
   _conn_start_ms(0),
   _i2c_address(i2c_address),
   _i2c_max(i2c_max),
   _uart_speed(0),
   _inbound_buffer_index(0),
   _inbound_buffer_size(0),
+  _inbound_buffer_capacity(inbound_buffer_capacity),
+  _binary_buffer_capacity(0),
+  _hub_set_start_ms(0),
+  _saved_transactions(0),
+  _binary_threshold(0),
+  _batch_window_ms(0),
+  _batch_max_bytes(0),
+  _batch_start_ms(0),
+  _batch_notes(0),
+  _batch_bytes(0),
+  _sync_count(0),
+  _synced_notes(0),
+  _synced_bytes(0),
+  _attn_pin(-1),
   _en_hw_int(en_hw_int),
+  _attn_signalled(true),
+  _hub_set_pending(false),
+  _configured_steps(0),
+  _init_step(InitStep::BEGIN),
   _topic_type{TopicType::Invalid},
   _notecard{},
   _device_id{},
@@ -121,19 +159,39 @@ NotecardConnectionHandler::NotecardConnectionHandler(
   uint32_t speed,
   bool en_hw_int,
   bool keep_alive,
-  const String & notehub_url
+  const String & notehub_url,
+  uint32_t inbound_buffer_capacity
 ) :
   ConnectionHandler{keep_alive, NetworkAdapter::NOTECARD},
   _serial(&serial),
   _wire(nullptr),
   _inbound_buffer(nullptr),
+  _binary_buffer(nullptr),
   _conn_start_ms(0),
   _i2c_address(0),
   _i2c_max(0),
   _uart_speed(speed),
   _inbound_buffer_index(0),
   _inbound_buffer_size(0),
+  _inbound_buffer_capacity(inbound_buffer_capacity),
+  _binary_buffer_capacity(0),
+  _hub_set_start_ms(0),
+  _saved_transactions(0),
+  _binary_threshold(0),
+  _batch_window_ms(0),
+  _batch_max_bytes(0),
+  _batch_start_ms(0),
+  _batch_notes(0),
+  _batch_bytes(0),
+  _sync_count(0),
+  _synced_notes(0),
+  _synced_bytes(0),
+  _attn_pin(-1),
   _en_hw_int(en_hw_int),
+  _attn_signalled(true),
+  _hub_set_pending(false),
+  _configured_steps(0),
+  _init_step(InitStep::BEGIN),
   _topic_type{TopicType::Invalid},
   _notecard{},
   _device_id{},
@@ -142,41 +200,67 @@ NotecardConnectionHandler::NotecardConnectionHandler(
   _project_uid(project_uid)
 { }
 
+NotecardConnectionHandler::~NotecardConnectionHandler()
+{
+  if (_attn_instance == this) {
+    _attn_instance = nullptr;
+  }
+  free(_inbound_buffer);
+  free(_binary_buffer);
+}
+
 /******************************************************************************
    PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
 unsigned long NotecardConnectionHandler::getTime(void)
 {
-  unsigned long result;
+  unsigned long result = getCachedTime();
 
-  if (J *rsp = _notecard.requestAndResponse(_notecard.newRequest("card.time"))) {
-    if (NoteResponseError(rsp)) {
-      const char *err = JGetString(rsp, "err");
-      Debug.print(DBG_ERROR, F("%s\n"), err);
-      result = 0;
+  if (!result) {
+    if (J *rsp = _notecard.requestAndResponse(_notecard.newRequest("card.time"))) {
+      if (NoteResponseError(rsp)) {
+        const char *err = JGetString(rsp, "err");
+        CH_LOG_ERROR("%s\n", err);
+        result = 0;
+      } else {
+        result = JGetInt(rsp, "time");
+      }
+      JDelete(rsp);
     } else {
-      result = JGetInt(rsp, "time");
+      result = 0;
     }
-    JDelete(rsp);
-  } else {
-    result = 0;
+    updateTimeCache(result);
   }
 
   return result;
 }
 
 int NotecardConnectionHandler::write(const uint8_t * buf, size_t size)
+{
+  return write(buf, size, false);
+}
+
+int NotecardConnectionHandler::write(const uint8_t * buf, size_t size, bool high_priority)
 {
   int result;
+  const bool batching = (_keep_alive && _batch_window_ms);
+  const bool binary = (buf && _binary_threshold && (size >= _binary_threshold));
 
-  if (J * req = _notecard.newRequest("note.add")) {
+  if (binary && !storeBinaryPayload(buf, size)) {
+    result = NotecardCommunicationError::NOTECARD_ERROR_GENERIC;
+  } else if (J * req = _notecard.newRequest("note.add")) {
     JAddStringToObject(req, "file", NOTEFILE_SSL_OUTBOUND);
-    if (buf) {
+    if (binary) {
+      // Attach the content of the binary buffer (requires a live Note)
+      JAddBoolToObject(req, "binary", true);
+      JAddBoolToObject(req, "live", true);
+    } else if (buf) {
       JAddBinaryToObject(req, "payload", buf, size);
     }
-    // Queue the Note when `_keep_alive` is disabled
-    if (_keep_alive) {
+    // Queue the Note when `_keep_alive` is disabled, or when batching (the
+    // whole batch is then synced at once by `syncBatch()`)
+    if (_keep_alive && !batching) {
       JAddBoolToObject(req, "sync", true);
     }
     if (J *body = JAddObjectToObject(req, "body")) {
@@ -184,11 +268,19 @@ int NotecardConnectionHandler::write(const uint8_t * buf, size_t size)
       J * rsp = _notecard.requestAndResponse(req);
       if (NoteResponseError(rsp)) {
         const char *err = JGetString(rsp, "err");
-        Debug.print(DBG_ERROR, F("%s\n"), err);
+        CH_LOG_ERROR("%s\n", err);
         result = NotecardCommunicationError::NOTECARD_ERROR_GENERIC;
       } else {
         result = NotecardCommunicationError::NOTECARD_ERROR_NONE;
-        Debug.print(DBG_INFO, F("Message sent correctly!"));
+        CH_LOG_INFO("Message sent correctly!");
+        if (batching) {
+          if (!_batch_notes) {
+            _batch_start_ms = ::millis();
+          }
+          ++_batch_notes;
+          _batch_bytes += size;
+          syncBatch(high_priority);
+        }
       }
       JDelete(rsp);
     } else {
@@ -217,15 +309,16 @@ int NotecardConnectionHandler::read()
 
 bool NotecardConnectionHandler::available()
 {
+  // Close the outbound batching window when due
+  syncBatch(false);
+
   bool buffered_data = (_inbound_buffer_index < _inbound_buffer_size);
   bool flush_required = !buffered_data && _inbound_buffer_size;
 
   // When the buffer is empty, look for a Note in the
   // NOTEFILE_SSL_INBOUND file to reload the buffer.
   if (!buffered_data) {
-    // Reset the buffer
-    free(_inbound_buffer);
-    _inbound_buffer = nullptr;
+    // Reset the buffer (the allocation is kept for the next Note)
     _inbound_buffer_index = 0;
     _inbound_buffer_size = 0;
 
@@ -233,20 +326,29 @@ bool NotecardConnectionHandler::available()
     // exhaustion (a.k.a. flush required). Returning `false` between Notes,
     // will break the read loop, force the CBOR buffer to be parsed, and the
     // property containers to be updated.
-    if (!flush_required) {
+    //
+    // When the ATTN pin is bound to an interrupt, the Notecard is only queried
+    // once it has signalled the arrival of a Note.
+    const bool attn_bound = (_en_hw_int && (_attn_pin >= 0));
+    if (!flush_required && (!attn_bound || _attn_signalled)) {
+      // Clear the flag before `getNote()` rearms the interrupt, so that a Note
+      // arriving in between is not missed. `getNote()` sets it again unless
+      // ATTN has actually been rearmed.
+      _attn_signalled = false;
+
       // Reload the buffer
       J *note = getNote(true);
       if (note) {
         if (J *body = JGetObject(note, "body")) {
           _topic_type = static_cast<TopicType>(JGetInt(body, "topic"));
           if (_topic_type == TopicType::Invalid) {
-            Debug.print(DBG_WARNING, F("Note does not contain a topic"));
+            CH_LOG_WARNING("Note does not contain a topic");
           } else {
-            buffered_data = JGetBinaryFromObject(note, "payload", &_inbound_buffer, &_inbound_buffer_size);
+            buffered_data = bufferPayload(note);
             if (!buffered_data) {
-              Debug.print(DBG_WARNING, F("Note does not contain payload data"));
+              CH_LOG_WARNING("Note does not contain payload data");
             } else {
-              Debug.print(DBG_DEBUG, F("New payload buffered with size: %d"), _inbound_buffer_size);
+              CH_LOG_DEBUG("New payload buffered with size: %d", _inbound_buffer_size);
             }
           }
         } else {
@@ -260,165 +362,262 @@ bool NotecardConnectionHandler::available()
   return buffered_data;
 }
 
+int NotecardConnectionHandler::read(uint8_t * buf, size_t len)
+{
+  const uint32_t size = payloadSize();
+  const uint32_t count = (size < len) ? size : len;
+
+  if (count) {
+    memcpy(buf, _inbound_buffer + _inbound_buffer_index, count);
+    _inbound_buffer_index += count;
+  }
+
+  return count;
+}
+
+int NotecardConnectionHandler::peek()
+{
+  int result;
+
+  if (_inbound_buffer_index < _inbound_buffer_size) {
+    result = _inbound_buffer[_inbound_buffer_index];
+  } else {
+    result = NotecardCommunicationError::NOTECARD_ERROR_NO_DATA_AVAILABLE;
+  }
+
+  return result;
+}
+
+size_t NotecardConnectionHandler::payloadSize()
+{
+  return (_inbound_buffer_size - _inbound_buffer_index);
+}
+
 /******************************************************************************
    PROTECTED MEMBER FUNCTIONS
  ******************************************************************************/
 
 NetworkConnectionState NotecardConnectionHandler::update_handleInit()
 {
-  NetworkConnectionState result;
+  NetworkConnectionState result = NetworkConnectionState::INIT;
 #if defined(LOG_MEMORY_USAGE)
   logMemoryUsage(__FUNCTION__, true);
 #endif
+
+  // Each step performs (at most) a single Notecard transaction, so that the
+  // initialization is spread across successive calls to `check()` instead of
+  // blocking until the whole configuration has been sent.
+  //
+  // The Notecard persists its configuration, so the requests it has already
+  // acknowledged are not sent again when reconnecting.
+  while ((InitStep::BEGIN != _init_step) && (InitStep::DEVICE_UID != _init_step) && (_configured_steps & initStepMask(_init_step))) {
+    ++_saved_transactions;
+    _init_step = nextInitStep(_init_step);
+  }
+
+  switch (_init_step) {
+    case InitStep::BEGIN:
+    {
 #if defined(STLINK_DEBUG)
-  // Output Notecard logs to the STLINK serial port
-  stlinkSerial.end();  // necessary to handle multiple initializations (e.g. reconnections)
-  stlinkSerial.begin(115200);
-  const size_t usb_timeout_ms = 3000;
-  for (const size_t start_ms = millis(); !stlinkSerial && (millis() - start_ms) < usb_timeout_ms;);
-  _notecard.setDebugOutputStream(stlinkSerial);
+      // Output Notecard logs to the STLINK serial port
+      stlinkSerial.end();  // necessary to handle multiple initializations (e.g. reconnections)
+      stlinkSerial.begin(115200);
+      const size_t usb_timeout_ms = 3000;
+      for (const size_t start_ms = millis(); !stlinkSerial && (millis() - start_ms) < usb_timeout_ms;);
+      _notecard.setDebugOutputStream(stlinkSerial);
 #endif
 
-  // Initialize the Notecard based on the configuration
-  if (_serial) {
-    _notecard.begin(*_serial, _uart_speed);
-  } else {
-    _notecard.begin(_i2c_address, _i2c_max, *_wire);
-  }
+      // Initialize the Notecard based on the configuration
+      if (_serial) {
+        _notecard.begin(*_serial, _uart_speed);
+      } else {
+        _notecard.begin(_i2c_address, _i2c_max, *_wire);
+      }
 
-  // Configure the ATTN pin to be used as an interrupt to indicate when a Note
-  // is available to read. `getNote()` will only arm the interrupt if no old
-  // Notes are available. If `ATTN` remains unarmed, it signals the user
-  // application that outstanding Notes are queued and need to be processed.
-  if (J *note = getNote(false)) {
-    JDelete(note);
-    result = NetworkConnectionState::INIT;
-  }
+      // Bind the ATTN pin to an interrupt, and assume a Note is pending until
+      // the Notecard reports otherwise
+      if (_en_hw_int && (_attn_pin >= 0)) {
+        if (_attn_instance && (_attn_instance != this)) {
+          CH_LOG_WARNING("ATTN interrupt already bound to another Notecard, polling instead");
+          _attn_pin = -1;
+        } else {
+          _attn_instance = this;
+          ::pinMode(_attn_pin, INPUT);
+          ::attachInterrupt(digitalPinToInterrupt(_attn_pin), onAttnInterrupt, RISING);
+        }
+        _attn_signalled = true;
+      }
 
-  // Set the project UID
-  if (NetworkConnectionState::INIT == result) {
-    if (configureConnection(true)) {
-      result = NetworkConnectionState::INIT;
-    } else {
-      result = NetworkConnectionState::ERROR;
+      // Configure the ATTN pin to be used as an interrupt to indicate when a Note
+      // is available to read. `getNote()` will only arm the interrupt if no old
+      // Notes are available. If `ATTN` remains unarmed, it signals the user
+      // application that outstanding Notes are queued and need to be processed.
+      if (J *note = getNote(false)) {
+        JDelete(note);
+      }
+      _init_step = InitStep::HUB_SET;
+      break;
     }
-  }
 
+    case InitStep::HUB_SET:
+    {
+      // Set the project UID
+      bool timed_out;
+      if (configureConnection(true, timed_out)) {
+        _configured_steps |= initStepMask(InitStep::HUB_SET);
+        _init_step = nextInitStep(InitStep::HUB_SET);
+      } else if (timed_out) {
+        result = NetworkConnectionState::ERROR;
+      }
+      break;
+    }
+
+    case InitStep::ENV_TEMPLATE:
+    {
 #if defined(BOARD_HAS_SECRET_KEY)
-  // Set environment variable template
-  if (NetworkConnectionState::INIT == result) {
-    if (J *req = NoteNewRequest("env.template")) {
-      if (J *body = JAddObjectToObject(req, "body")) {
-        JAddStringToObject(body, "arduino_iot_cloud_secret_key", TSTRING(64));
-        if (J *rsp = _notecard.requestAndResponse(req)) {
-          // Check the response for errors
-          if (NoteResponseError(rsp)) {
-            const char *err = JGetString(rsp, "err");
-            Debug.print(DBG_ERROR, F("%s"), err);
-            result = NetworkConnectionState::ERROR;
+      // Set environment variable template
+      if (J *req = NoteNewRequest("env.template")) {
+        if (J *body = JAddObjectToObject(req, "body")) {
+          JAddStringToObject(body, "arduino_iot_cloud_secret_key", TSTRING(64));
+          if (J *rsp = _notecard.requestAndResponse(req)) {
+            // Check the response for errors
+            if (NoteResponseError(rsp)) {
+              const char *err = JGetString(rsp, "err");
+              CH_LOG_ERROR("%s", err);
+              result = NetworkConnectionState::ERROR;
+            } else {
+              result = NetworkConnectionState::INIT;
+              _configured_steps |= initStepMask(InitStep::ENV_TEMPLATE);
+            }
+            JDelete(rsp);
           } else {
-            result = NetworkConnectionState::INIT;
+            CH_LOG_ERROR("Failed to receive response from Notecard.");
+            result = NetworkConnectionState::ERROR; // Assume the worst
           }
-          JDelete(rsp);
         } else {
-          Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+          CH_LOG_ERROR("Failed to allocate request: " "env.template" ":body");
+          JFree(req);
           result = NetworkConnectionState::ERROR; // Assume the worst
         }
       } else {
-        Debug.print(DBG_ERROR, "Failed to allocate request: " "env.template" ":body");
-        JFree(req);
+        CH_LOG_ERROR("Failed to allocate request: " "env.template");
         result = NetworkConnectionState::ERROR; // Assume the worst
       }
-    } else {
-      Debug.print(DBG_ERROR, "Failed to allocate request: " "env.template");
-      result = NetworkConnectionState::ERROR; // Assume the worst
-    }
-  }
 #endif
+      _init_step = InitStep::INBOUND_TEMPLATE;
+      break;
+    }
 
-  // Set inbound template to support LoRa/Satellite Notecard
-  if (NetworkConnectionState::INIT == result) {
-    if (J *req = _notecard.newRequest("note.template")) {
-      JAddStringToObject(req, "file", NOTEFILE_SSL_INBOUND);
-      JAddStringToObject(req, "format", "compact");              // Support LoRa/Satellite Notecards
-      JAddIntToObject(req, "port", NOTEFILE_INBOUND_LORA_PORT);  // Support LoRa/Satellite Notecards
-      if (J *body = JAddObjectToObject(req, "body")) {
-        JAddIntToObject(body, "topic", TUINT8);
-        if (J *rsp = _notecard.requestAndResponse(req)) {
-          // Check the response for errors
-          if (NoteResponseError(rsp)) {
-            const char *err = JGetString(rsp, "err");
-            Debug.print(DBG_ERROR, F("%s"), err);
-            result = NetworkConnectionState::ERROR;
+    case InitStep::INBOUND_TEMPLATE:
+    {
+      // Set inbound template to support LoRa/Satellite Notecard
+      if (J *req = _notecard.newRequest("note.template")) {
+        JAddStringToObject(req, "file", NOTEFILE_SSL_INBOUND);
+        JAddStringToObject(req, "format", "compact");              // Support LoRa/Satellite Notecards
+        JAddIntToObject(req, "port", NOTEFILE_INBOUND_LORA_PORT);  // Support LoRa/Satellite Notecards
+        if (J *body = JAddObjectToObject(req, "body")) {
+          JAddIntToObject(body, "topic", TUINT8);
+          if (J *rsp = _notecard.requestAndResponse(req)) {
+            // Check the response for errors
+            if (NoteResponseError(rsp)) {
+              const char *err = JGetString(rsp, "err");
+              CH_LOG_ERROR("%s", err);
+              result = NetworkConnectionState::ERROR;
+            } else {
+              result = NetworkConnectionState::INIT;
+              _configured_steps |= initStepMask(InitStep::INBOUND_TEMPLATE);
+            }
+            JDelete(rsp);
           } else {
-            result = NetworkConnectionState::INIT;
+            CH_LOG_ERROR("Failed to receive response from Notecard.");
+            result = NetworkConnectionState::ERROR; // Assume the worst
           }
-          JDelete(rsp);
         } else {
-          Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+          CH_LOG_ERROR("Failed to allocate request: " "note.template" ":body");
+          JFree(req);
           result = NetworkConnectionState::ERROR; // Assume the worst
         }
       } else {
-        Debug.print(DBG_ERROR, "Failed to allocate request: " "note.template" ":body");
-        JFree(req);
+        CH_LOG_ERROR("Failed to allocate request: " "note.template");
         result = NetworkConnectionState::ERROR; // Assume the worst
       }
-    } else {
-      Debug.print(DBG_ERROR, "Failed to allocate request: " "note.template");
-      result = NetworkConnectionState::ERROR; // Assume the worst
+      _init_step = InitStep::OUTBOUND_TEMPLATE;
+      break;
     }
-  }
 
-  // Set outbound template to remove payload size restrictions
-  if (NetworkConnectionState::INIT == result) {
-    if (J *req = _notecard.newRequest("note.template")) {
-      JAddStringToObject(req, "file", NOTEFILE_SSL_OUTBOUND);
-      JAddStringToObject(req, "format", "compact");               // Support LoRa/Satellite Notecards
-      JAddIntToObject(req, "port", NOTEFILE_OUTBOUND_LORA_PORT);  // Support LoRa/Satellite Notecards
-      if (J *body = JAddObjectToObject(req, "body")) {
-        JAddIntToObject(body, "topic", TUINT8);
-        if (J *rsp = _notecard.requestAndResponse(req)) {
-          // Check the response for errors
-          if (NoteResponseError(rsp)) {
-            const char *err = JGetString(rsp, "err");
-            Debug.print(DBG_ERROR, F("%s"), err);
-            result = NetworkConnectionState::ERROR;
+    case InitStep::OUTBOUND_TEMPLATE:
+    {
+      // Set outbound template to remove payload size restrictions
+      if (J *req = _notecard.newRequest("note.template")) {
+        JAddStringToObject(req, "file", NOTEFILE_SSL_OUTBOUND);
+        JAddStringToObject(req, "format", "compact");               // Support LoRa/Satellite Notecards
+        JAddIntToObject(req, "port", NOTEFILE_OUTBOUND_LORA_PORT);  // Support LoRa/Satellite Notecards
+        if (J *body = JAddObjectToObject(req, "body")) {
+          JAddIntToObject(body, "topic", TUINT8);
+          if (J *rsp = _notecard.requestAndResponse(req)) {
+            // Check the response for errors
+            if (NoteResponseError(rsp)) {
+              const char *err = JGetString(rsp, "err");
+              CH_LOG_ERROR("%s", err);
+              result = NetworkConnectionState::ERROR;
+            } else {
+              result = NetworkConnectionState::INIT;
+              _configured_steps |= initStepMask(InitStep::OUTBOUND_TEMPLATE);
+            }
+            JDelete(rsp);
           } else {
-            result = NetworkConnectionState::INIT;
+            CH_LOG_ERROR("Failed to receive response from Notecard.");
+            result = NetworkConnectionState::ERROR; // Assume the worst
           }
-          JDelete(rsp);
         } else {
-          Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+          CH_LOG_ERROR("Failed to allocate request: " "note.template" ":body");
+          JFree(req);
           result = NetworkConnectionState::ERROR; // Assume the worst
         }
       } else {
-        Debug.print(DBG_ERROR, "Failed to allocate request: " "note.template" ":body");
-        JFree(req);
+        CH_LOG_ERROR("Failed to allocate request: " "note.template");
         result = NetworkConnectionState::ERROR; // Assume the worst
       }
-    } else {
-      Debug.print(DBG_ERROR, "Failed to allocate request: " "note.template");
-      result = NetworkConnectionState::ERROR; // Assume the worst
+      _init_step = InitStep::DEVICE_UID;
+      break;
     }
-  }
 
-  // Get the device UID
-  if (NetworkConnectionState::INIT == result) {
-    if (!updateUidCache()) {
-      result = NetworkConnectionState::ERROR;
-    } else {
-      Debug.print(DBG_INFO, F("Notecard has been initialized."));
-      if (_keep_alive) {
-        _conn_start_ms = ::millis();
-        Debug.print(DBG_INFO, F("Starting network connection..."));
-        result = NetworkConnectionState::CONNECTING;
+    case InitStep::DEVICE_UID:
+    {
+      // Get the device UID, unless it has already been cached
+      const bool uid_cached = (_configured_steps & initStepMask(InitStep::DEVICE_UID));
+      if (uid_cached) {
+        ++_saved_transactions;
+      }
+      if (!uid_cached && !updateUidCache()) {
+        result = NetworkConnectionState::ERROR;
       } else {
-        Debug.print(DBG_INFO, F("Network is disconnected."));
-        result = NetworkConnectionState::DISCONNECTED;
+        _configured_steps |= initStepMask(InitStep::DEVICE_UID);
+        CH_LOG_INFO("Notecard has been initialized.");
+        if (_keep_alive) {
+          _conn_start_ms = ::millis();
+          CH_LOG_INFO("Starting network connection...");
+          result = NetworkConnectionState::CONNECTING;
+        } else {
+          CH_LOG_INFO("Network is disconnected.");
+          result = NetworkConnectionState::DISCONNECTED;
+        }
       }
+      break;
     }
   }
 
+  // Only a `hub.set` timeout leaves the step unchanged on failure, any other
+  // failing step has been rejected by the Notecard
+  if (NetworkConnectionState::ERROR == result) {
+    setTransitionReason((InitStep::HUB_SET == _init_step) ? TransitionReason::TIMEOUT : TransitionReason::CONFIG_FAILED);
+  }
+
+  // Start over on the next initialization
+  if (NetworkConnectionState::INIT != result) {
+    _init_step = InitStep::BEGIN;
+  }
+
 #if defined(LOG_MEMORY_USAGE)
   logMemoryUsage(__FUNCTION__);
 #endif
@@ -438,20 +637,22 @@ NetworkConnectionState NotecardConnectionHandler::update_handleConnecting()
   // Update the connection state
   if (!conn_status.connected_to_notehub) {
     if ((::millis() - _conn_start_ms) > NOTEHUB_CONN_TIMEOUT_MS) {
-      Debug.print(DBG_ERROR, F("Timeout exceeded, connection to the network failed."));
-      Debug.print(DBG_INFO, F("Retrying in \"%d\" milliseconds"), CHECK_INTERVAL_TABLE[static_cast<unsigned int>(NetworkConnectionState::CONNECTING)]);
+      CH_LOG_ERROR("Timeout exceeded, connection to the network failed.");
+      CH_LOG_INFO("Retrying in \"%d\" milliseconds", getCheckInterval(NetworkConnectionState::CONNECTING));
+      setTransitionReason(TransitionReason::TIMEOUT);
+      connectionAttemptFailed();
       result = NetworkConnectionState::INIT;
     } else {
       // Continue awaiting the connection to Notehub
       if (conn_status.transport_connected) {
-        Debug.print(DBG_INFO, F("Establishing connection to Notehub..."));
+        CH_LOG_INFO("Establishing connection to Notehub...");
       } else {
-        Debug.print(DBG_INFO, F("Connecting to the network..."));
+        CH_LOG_INFO("Connecting to the network...");
       }
       result = NetworkConnectionState::CONNECTING;
     }
   } else {
-    Debug.print(DBG_INFO, F("Connected to Notehub!"));
+    CH_LOG_INFO("Connected to Notehub!");
     result = NetworkConnectionState::CONNECTED;
   }
 
@@ -468,13 +669,17 @@ NetworkConnectionState NotecardConnectionHandler::update_handleConnected()
   logMemoryUsage(__FUNCTION__, true);
 #endif
 
+  // Close the outbound batching window when due
+  syncBatch(false);
+
   const NotecardConnectionStatus conn_status = connected();
   if (!conn_status.connected_to_notehub) {
     if (!conn_status.transport_connected) {
-      Debug.print(DBG_ERROR, F("Connection to the network lost."));
+      CH_LOG_ERROR("Connection to the network lost.");
     } else {
-      Debug.print(DBG_ERROR, F("Connection to Notehub lost."));
+      CH_LOG_ERROR("Connection to Notehub lost.");
     }
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     result = NetworkConnectionState::DISCONNECTED;
   } else {
     result = NetworkConnectionState::CONNECTED;
@@ -493,7 +698,9 @@ NetworkConnectionState NotecardConnectionHandler::update_handleDisconnecting()
   logMemoryUsage(__FUNCTION__, true);
 #endif
 
-  Debug.print(DBG_ERROR, F("Connection to the network lost."));
+  CH_LOG_ERROR("Connection to the network lost.");
+  _init_step = InitStep::BEGIN;
+  _hub_set_pending = false;
   result = NetworkConnectionState::DISCONNECTED;
 
 #if defined(LOG_MEMORY_USAGE)
@@ -511,17 +718,26 @@ NetworkConnectionState NotecardConnectionHandler::update_handleDisconnected()
 
   if (_keep_alive)
   {
-    Debug.print(DBG_ERROR, F("Attempting reconnection..."));
+    CH_LOG_ERROR("Attempting reconnection...");
     result = NetworkConnectionState::INIT;
   }
   else
   {
-    if (configureConnection(false)) {
+    // Closing the connection overrides the `hub.set` sent during the
+    // initialization, which must therefore be sent again on reconnection
+    _configured_steps &= ~initStepMask(InitStep::HUB_SET);
+
+    bool timed_out;
+    if (configureConnection(false, timed_out)) {
       result = NetworkConnectionState::CLOSED;
-      Debug.print(DBG_INFO, F("Closing connection..."));
-    } else {
+      CH_LOG_INFO("Closing connection...");
+    } else if (timed_out) {
+      setTransitionReason(TransitionReason::TIMEOUT);
       result = NetworkConnectionState::ERROR;
-      Debug.print(DBG_INFO, F("Error closing connection..."));
+      CH_LOG_INFO("Error closing connection...");
+    } else {
+      // Retry on the next call to `check()`
+      result = NetworkConnectionState::DISCONNECTED;
     }
   }
 
@@ -535,6 +751,12 @@ NetworkConnectionState NotecardConnectionHandler::update_handleDisconnected()
    PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
 
+void NotecardConnectionHandler::onAttnInterrupt(void) {
+  if (NotecardConnectionHandler * instance = _attn_instance) {
+    instance->_attn_signalled = true;
+  }
+}
+
 bool NotecardConnectionHandler::armInterrupt(void) /* const */{
   bool result;
 #if defined(LOG_MEMORY_USAGE)
@@ -554,26 +776,103 @@ bool NotecardConnectionHandler::armInterrupt(void) /* const */{
           // severe errors would occur in isolation. Once the Notecard firmware
           // is updated to support idempotent `rearm` requests, this error will
           // be handled as a failure.
-          Debug.print(DBG_VERBOSE, F("%s"), err);
+          CH_LOG_VERBOSE("%s", err);
           result = true;  // Ignore the error
-          // Debug.print(DBG_ERROR, F("%s\n"), err);
+          // CH_LOG_ERROR("%s\n", err);
           // result = false;
         } else {
           result = true;
         }
         JDelete(rsp);
       } else {
-        Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+        CH_LOG_ERROR("Failed to receive response from Notecard.");
         result = false;
       }
     } else {
-      Debug.print(DBG_ERROR, "Failed to allocate request: " "card.attn" ":files");
+      CH_LOG_ERROR("Failed to allocate request: " "card.attn" ":files");
       JFree(req);
       result = false;
     }
   } else {
-    Debug.print(DBG_ERROR, "Failed to allocate request: " "card.attn");
+    CH_LOG_ERROR("Failed to allocate request: " "card.attn");
+    result = false;
+  }
+
+#if defined(LOG_MEMORY_USAGE)
+  logMemoryUsage(__FUNCTION__);
+#endif
+  return result;
+}
+
+bool NotecardConnectionHandler::bufferPayload(J * note) {
+  bool result;
+
+  // Decode the payload directly into the inbound buffer, instead of letting
+  // `JGetBinaryFromObject()` allocate a new buffer for every Note. The buffer
+  // is only ever grown, so it stops churning the heap once it has reached the
+  // size of the largest payload received.
+  const char *payload = JGetString(note, "payload");
+  if (payload && *payload) {
+    // Upper bound of the decoded size, including the trailing '\0'
+    const uint32_t decoded_len = JB64DecodeLen(payload);
+    if (!_inbound_buffer || (decoded_len > _inbound_buffer_capacity)) {
+      const uint32_t capacity = (decoded_len > _inbound_buffer_capacity ? decoded_len : _inbound_buffer_capacity);
+      if (uint8_t *buffer = static_cast<uint8_t *>(realloc(_inbound_buffer, capacity))) {
+        _inbound_buffer = buffer;
+        _inbound_buffer_capacity = capacity;
+      } else {
+        CH_LOG_ERROR("Failed to allocate inbound buffer of size: %d", capacity);
+      }
+    }
+
+    if (_inbound_buffer && (decoded_len <= _inbound_buffer_capacity)) {
+      _inbound_buffer_size = JB64Decode(reinterpret_cast<char *>(_inbound_buffer), payload);
+      result = (_inbound_buffer_size > 0);
+    } else {
+      result = false;
+    }
+  } else {
+    result = false;
+  }
+
+  return result;
+}
+
+bool NotecardConnectionHandler::storeBinaryPayload(const uint8_t * buf, size_t size) {
+  bool result;
+#if defined(LOG_MEMORY_USAGE)
+  logMemoryUsage(__FUNCTION__, true);
+#endif
+
+  // `NoteBinaryStoreTransmit()` encodes the data in place, so the payload is
+  // copied chunk by chunk into a staging buffer large enough to hold it. As
+  // for the inbound buffer, it is only ever grown, up to the chunk size.
+  const size_t chunk_max = (size < NOTECARD_BINARY_CHUNK_SIZE) ? size : NOTECARD_BINARY_CHUNK_SIZE;
+  const uint32_t staging_size = NOTECARD_BINARY_STAGING_SIZE(chunk_max);
+  if (!_binary_buffer || (staging_size > _binary_buffer_capacity)) {
+    if (uint8_t *buffer = static_cast<uint8_t *>(realloc(_binary_buffer, staging_size))) {
+      _binary_buffer = buffer;
+      _binary_buffer_capacity = staging_size;
+    } else {
+      CH_LOG_ERROR("Failed to allocate binary buffer of size: %d", staging_size);
+    }
+  }
+
+  if (!_binary_buffer || (staging_size > _binary_buffer_capacity)) {
+    result = false;
+  } else if (const char *err = NoteBinaryStoreReset()) {
+    CH_LOG_ERROR("%s", err);
     result = false;
+  } else {
+    result = true;
+    for (size_t offset = 0; result && (offset < size); offset += chunk_max) {
+      const size_t chunk_size = ((size - offset) < chunk_max) ? (size - offset) : chunk_max;
+      memcpy(_binary_buffer, buf + offset, chunk_size);
+      if (const char *err = NoteBinaryStoreTransmit(_binary_buffer, chunk_size, _binary_buffer_capacity, offset)) {
+        CH_LOG_ERROR("%s", err);
+        result = false;
+      }
+    }
   }
 
 #if defined(LOG_MEMORY_USAGE)
@@ -582,12 +881,53 @@ bool NotecardConnectionHandler::armInterrupt(void) /* const */{
   return result;
 }
 
-bool NotecardConnectionHandler::configureConnection (bool connect) /* const */{
+bool NotecardConnectionHandler::syncBatch(bool force) {
+  bool result = false;
+
+  const bool window_closed = ((::millis() - _batch_start_ms) >= _batch_window_ms);
+  const bool bytes_exceeded = (_batch_max_bytes && (_batch_bytes >= _batch_max_bytes));
+  if (_batch_notes && (force || window_closed || bytes_exceeded)) {
+    if (J *rsp = _notecard.requestAndResponse(_notecard.newRequest("hub.sync"))) {
+      // Check the response for errors
+      if (NoteResponseError(rsp)) {
+        const char *err = JGetString(rsp, "err");
+        CH_LOG_ERROR("%s", err);
+      } else {
+        CH_LOG_DEBUG("Synced %d Notes (%d bytes)", _batch_notes, _batch_bytes);
+        ++_sync_count;
+        _synced_notes += _batch_notes;
+        _synced_bytes += _batch_bytes;
+        _batch_notes = 0;
+        _batch_bytes = 0;
+        result = true;
+      }
+      JDelete(rsp);
+    } else {
+      CH_LOG_ERROR("Failed to receive response from Notecard.");
+    }
+
+    // Retry a failed sync once the next window has elapsed
+    if (!result) {
+      _batch_start_ms = ::millis();
+    }
+  }
+
+  return result;
+}
+
+bool NotecardConnectionHandler::configureConnection (bool connect, bool & timed_out) /* const */{
   bool result;
 #if defined(LOG_MEMORY_USAGE)
   logMemoryUsage(__FUNCTION__, true);
 #endif
 
+  // Keep track of the time elapsed since the first attempt, so that the
+  // caller can retry on subsequent calls until the timeout is exceeded.
+  if (!_hub_set_pending) {
+    _hub_set_pending = true;
+    _hub_set_start_ms = ::millis();
+  }
+
   if (J *req = _notecard.newRequest("hub.set")) {
     JAddStringToObject(req, "host", _notehub_url.c_str());
     JAddStringToObject(req, "product", _project_uid.c_str());
@@ -602,25 +942,30 @@ bool NotecardConnectionHandler::configureConnection (bool connect) /* const */{
       JAddStringToObject(req, "vinbound", "-");
       JAddStringToObject(req, "voutbound", "-");
     }
-    if (J *rsp = _notecard.requestAndResponseWithRetry(req, 30)) {
+    if (J *rsp = _notecard.requestAndResponse(req)) {
       // Check the response for errors
       if (NoteResponseError(rsp)) {
         const char *err = JGetString(rsp, "err");
-        Debug.print(DBG_ERROR, F("%s"), err);
+        CH_LOG_ERROR("%s", err);
         result = false;
       } else {
         result = true;
       }
       JDelete(rsp);
     } else {
-      Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+      CH_LOG_ERROR("Failed to receive response from Notecard.");
       result = false; // Assume the worst
     }
   } else {
-    Debug.print(DBG_ERROR, "Failed to allocate request: " "hub.set");
+    CH_LOG_ERROR("Failed to allocate request: " "hub.set");
     result = false; // Assume the worst
   }
 
+  timed_out = (!result && (::millis() - _hub_set_start_ms) > HUB_SET_RETRY_TIMEOUT_MS);
+  if (result || timed_out) {
+    _hub_set_pending = false;
+  }
+
 #if defined(LOG_MEMORY_USAGE)
   logMemoryUsage(__FUNCTION__);
 #endif
@@ -638,7 +983,7 @@ uint_fast8_t NotecardConnectionHandler::connected(void) /* const */{
     // Ensure the transaction doesn't return an error
     if (NoteResponseError(rsp)) {
       const char *err = JGetString(rsp, "err");
-      Debug.print(DBG_ERROR, F("%s"),err);
+      CH_LOG_ERROR("%s",err);
       result.notecard_error = true;
     } else {
       // Parse the transport connection status
@@ -655,7 +1000,7 @@ uint_fast8_t NotecardConnectionHandler::connected(void) /* const */{
     // Free the response
     JDelete(rsp);
   } else {
-    Debug.print(DBG_ERROR, F("Failed to acquire Notecard connection status."));
+    CH_LOG_ERROR("Failed to acquire Notecard connection status.");
     result.transport_connected = false;
     result.connected_to_notehub = false;
     result.notecard_error = false;
@@ -670,10 +1015,43 @@ uint_fast8_t NotecardConnectionHandler::connected(void) /* const */{
 
 J * NotecardConnectionHandler::getNote(bool pop) /* const */{
   J * result;
+  bool empty = false;
+  bool rearmed = false;
 #if defined(LOG_MEMORY_USAGE)
   logMemoryUsage(__FUNCTION__, true);
 #endif
 
+  result = requestNote(pop, empty);
+
+  // The Notefile is empty, rearm ATTN to be signalled of the next Note. A Note
+  // arriving between the `note.get` and the rearm would not be signalled, so
+  // the Notefile is queried once more after rearming, unless the next call to
+  // `available()` queries it anyway (polling, or already signalled).
+  if (empty && _en_hw_int) {
+    rearmed = armInterrupt();
+    if (rearmed && (_attn_pin >= 0) && !_attn_signalled) {
+      result = requestNote(pop, empty);
+      rearmed = empty;
+    }
+  }
+
+  // ATTN only signals the next Note once it has been rearmed. Otherwise more
+  // Notes may be queued (or the transaction failed), so the Notefile must be
+  // queried again on the next call to `available()`.
+  if (!rearmed) {
+    _attn_signalled = true;
+  }
+
+#if defined(LOG_MEMORY_USAGE)
+  logMemoryUsage(__FUNCTION__);
+#endif
+  return result;
+}
+
+J * NotecardConnectionHandler::requestNote(bool pop, bool & empty) /* const */{
+  J * result;
+  empty = false;
+
   // Look for a Note in the NOTEFILE_SSL_INBOUND file
   if (J *req = _notecard.newRequest("note.get")) {
     JAddStringToObject(req, "file", NOTEFILE_SSL_INBOUND);
@@ -686,9 +1064,7 @@ J * NotecardConnectionHandler::getNote(bool pop) /* const */{
         const char *jErr = JGetString(note, "err");
         if (NoteErrorContains(jErr, "{note-noexist}")) {
           // The Notefile is empty, thus no Note is available.
-          if (_en_hw_int) {
-            armInterrupt();
-          }
+          empty = true;
         } else {
           // Any other error indicates that we were unable to
           // retrieve a Note, therefore no Note is available.
@@ -701,18 +1077,15 @@ J * NotecardConnectionHandler::getNote(bool pop) /* const */{
         result = note;
       }
     } else {
-      Debug.print(DBG_ERROR, F("Failed to receive response from Notecard."));
+      CH_LOG_ERROR("Failed to receive response from Notecard.");
       result = nullptr;
     }
   } else {
-    Debug.print(DBG_ERROR, "Failed to allocate request: " "note.get");
+    CH_LOG_ERROR("Failed to allocate request: " "note.get");
     // Failed to retrieve a Note, therefore no Note is available.
     result = nullptr;
   }
 
-#if defined(LOG_MEMORY_USAGE)
-  logMemoryUsage(__FUNCTION__);
-#endif
   return result;
 }
 
@@ -727,18 +1100,18 @@ bool NotecardConnectionHandler::updateUidCache(void) {
     // Check the response for errors
     if (NoteResponseError(rsp)) {
       const char *err = JGetString(rsp, "err");
-      Debug.print(DBG_ERROR, F("Failed to read Notecard UID"));
-      Debug.print(DBG_ERROR, F("Error: %s"), err);
+      CH_LOG_ERROR("Failed to read Notecard UID");
+      CH_LOG_ERROR("Error: %s", err);
       result = false;
     } else {
       _notecard_uid = JGetString(rsp, "device");
       _device_id = JGetString(rsp, "sn");
-      Debug.print(DBG_DEBUG, F("Cached Notecard UID: <%s> and Arduino Device ID: <%s>"), _notecard_uid.c_str(), _device_id.c_str());
+      CH_LOG_DEBUG("Cached Notecard UID: <%s> and Arduino Device ID: <%s>", _notecard_uid.c_str(), _device_id.c_str());
       result = true;
     }
     JDelete(rsp);
   } else {
-    Debug.print(DBG_ERROR, F("Failed to read Notecard UID"));
+    CH_LOG_ERROR("Failed to read Notecard UID");
     result = false;
   }
 
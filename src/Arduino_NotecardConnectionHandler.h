@@ -35,7 +35,7 @@
    CLASS DECLARATION
  ******************************************************************************/
 
-class NotecardConnectionHandler final : public ConnectionHandler
+class NotecardConnectionHandler : public ConnectionHandler
 {
   public:
     enum class TopicType : uint8_t {
@@ -54,6 +54,7 @@ class NotecardConnectionHandler final : public ConnectionHandler
     } NotecardCommunicationError;
 
     static const uint32_t NOTEHUB_CONN_TIMEOUT_MS = 185000;
+    static const uint32_t DEFAULT_INBOUND_BUFFER_CAPACITY = 256;
 
     NotecardConnectionHandler(
       const String & project_uid,
@@ -62,7 +63,8 @@ class NotecardConnectionHandler final : public ConnectionHandler
       uint32_t i2c_address = NOTE_I2C_ADDR_DEFAULT,
       uint32_t i2c_max = NOTE_I2C_MAX_DEFAULT,
       TwoWire & wire = Wire,
-      const String & notehub_url = "-"
+      const String & notehub_url = "-",
+      uint32_t inbound_buffer_capacity = DEFAULT_INBOUND_BUFFER_CAPACITY
     );
 
     NotecardConnectionHandler(
@@ -71,9 +73,16 @@ class NotecardConnectionHandler final : public ConnectionHandler
       uint32_t speed = 9600,
       bool en_hw_int = false,
       bool keep_alive = true,
-      const String & notehub_url = "-"
+      const String & notehub_url = "-",
+      uint32_t inbound_buffer_capacity = DEFAULT_INBOUND_BUFFER_CAPACITY
     );
 
+    ~NotecardConnectionHandler();
+
+    // The inbound buffer is owned by the handler, which can't be copied
+    NotecardConnectionHandler(const NotecardConnectionHandler &) = delete;
+    NotecardConnectionHandler & operator=(const NotecardConnectionHandler &) = delete;
+
     // Accessors for Unique Hardware Identifiers
     const String & getArduinoDeviceId(void) const {
       return _device_id;
@@ -82,6 +91,52 @@ class NotecardConnectionHandler final : public ConnectionHandler
       return _notecard_uid;
     }
 
+    // Number of configuration requests skipped on reconnection, because the
+    // Notecard had already acknowledged them
+    uint32_t getSavedTransactions(void) const {
+      return _saved_transactions;
+    }
+    // Force the whole configuration to be sent on the next initialization
+    // (e.g. after the Notecard has been replaced or factory reset)
+    void invalidateConfiguration(void) {
+      _configured_steps = 0;
+    }
+
+    // Route the Notecard ATTN pin to an interrupt, so that `available()` only
+    // queries the Notecard once a Note has been signalled. Requires `en_hw_int`
+    // and must be called before the first call to `check()`. Only one instance
+    // can be bound to the interrupt, any other one keeps polling.
+    void setAttnPin(int pin) {
+      _attn_pin = pin;
+    }
+
+    // Payloads of at least `size` bytes are transferred raw through the
+    // Notecard binary buffer (`card.binary`) instead of being base64 encoded
+    // into the Note. Binary Notes are sent live. A size of 0 disables it. Each
+    // chunk of up to 4 KiB costs a transaction and is staged in a heap buffer,
+    // so small payloads are faster base64 encoded.
+    void setBinaryTransferThreshold(uint32_t size) {
+      _binary_threshold = size;
+    }
+
+    // Batch outbound Notes (keep_alive only): instead of syncing every Note,
+    // Notes are queued and a single `hub.sync` is issued once `window_ms` has
+    // elapsed since the first queued Note, or `max_bytes` have been queued
+    // (0 for no byte threshold). A `window_ms` of 0 disables batching.
+    void setSyncBatching(uint32_t window_ms, uint32_t max_bytes = 0) {
+      _batch_window_ms = window_ms;
+      _batch_max_bytes = max_bytes;
+    }
+    uint32_t getSyncCount(void) const {
+      return _sync_count;
+    }
+    uint32_t getNotesPerSync(void) const {
+      return (_sync_count ? (_synced_notes / _sync_count) : 0);
+    }
+    uint32_t getBytesPerSync(void) const {
+      return (_sync_count ? (_synced_bytes / _sync_count) : 0);
+    }
+
     // Identify the target topic for R/W operations
     TopicType getTopicType(void) const {
       return _topic_type;
@@ -93,8 +148,13 @@ class NotecardConnectionHandler final : public ConnectionHandler
     // ConnectionHandler interface
     virtual unsigned long getTime() override;
     virtual int write(const uint8_t *buf, size_t size) override;
+    // A high priority write closes the batching window immediately
+    int write(const uint8_t *buf, size_t size, bool high_priority);
     virtual int read() override;
     virtual bool available() override;
+    virtual int read(uint8_t *buf, size_t len) override;
+    virtual int peek() override;
+    virtual size_t payloadSize() override;
 
   protected:
 
@@ -106,17 +166,61 @@ class NotecardConnectionHandler final : public ConnectionHandler
 
   private:
 
+    enum class InitStep : uint8_t {
+      BEGIN,
+      HUB_SET,
+      ENV_TEMPLATE,
+      INBOUND_TEMPLATE,
+      OUTBOUND_TEMPLATE,
+      DEVICE_UID
+    };
+
+    static constexpr uint8_t initStepMask (InitStep step) {
+      return (1 << static_cast<uint8_t>(step));
+    }
+    static constexpr InitStep nextInitStep (InitStep step) {
+#if defined(BOARD_HAS_SECRET_KEY)
+      return static_cast<InitStep>(static_cast<uint8_t>(step) + 1);
+#else
+      // Without a secret key, there is no environment variable template to set
+      return (InitStep::HUB_SET == step) ? InitStep::INBOUND_TEMPLATE : static_cast<InitStep>(static_cast<uint8_t>(step) + 1);
+#endif
+    }
+
+    // The ATTN interrupt service routine signals the instance it is bound to
+    static NotecardConnectionHandler * volatile _attn_instance;
+    static void onAttnInterrupt (void);
+
     // Private members
     HardwareSerial * _serial;
     TwoWire * _wire;
     uint8_t * _inbound_buffer;
+    uint8_t * _binary_buffer;
     uint32_t _conn_start_ms;
     uint32_t _i2c_address;
     uint32_t _i2c_max;
     uint32_t _uart_speed;
     uint32_t _inbound_buffer_index;
     uint32_t _inbound_buffer_size;
+    uint32_t _inbound_buffer_capacity;
+    uint32_t _binary_buffer_capacity;
+    uint32_t _hub_set_start_ms;
+    uint32_t _saved_transactions;
+    uint32_t _binary_threshold;
+    uint32_t _batch_window_ms;
+    uint32_t _batch_max_bytes;
+    uint32_t _batch_start_ms;
+    uint32_t _batch_notes;
+    uint32_t _batch_bytes;
+    uint32_t _sync_count;
+    uint32_t _synced_notes;
+    uint32_t _synced_bytes;
+    int _attn_pin;
     bool _en_hw_int;
+    volatile bool _attn_signalled;
+    bool _hub_set_pending;
+    uint8_t _configured_steps;
+    InitStep _init_step;
     TopicType _topic_type;
     Notecard _notecard;
     String _device_id;
@@ -126,9 +230,13 @@ class NotecardConnectionHandler final : public ConnectionHandler
 
     // Private methods
     bool armInterrupt (void) /* const */;
-    bool configureConnection (bool connect) /* const */;
+    bool bufferPayload (J * note);
+    bool storeBinaryPayload (const uint8_t * buf, size_t size);
+    bool syncBatch (bool force);
+    bool configureConnection (bool connect, bool & timed_out) /* const */;
     uint_fast8_t connected (void) /* const */;
     J * getNote (bool pop = false) /* const */;
+    J * requestNote (bool pop, bool & empty) /* const */;
     bool updateUidCache (void);
 };
 
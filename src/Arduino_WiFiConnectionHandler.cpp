@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "Arduino_WiFiConnectionHandler.h"
+#include "Arduino_ConnectionHandlerLog.h"
 
 #ifdef BOARD_HAS_WIFI /* Only compile if the board has WiFi */
 
@@ -27,7 +28,33 @@
    CONSTANTS
  ******************************************************************************/
 #if defined(ARDUINO_ARCH_ESP8266)
-static int const ESP_WIFI_CONNECTION_TIMEOUT = 3000;
+static unsigned long const ESP_WIFI_CONNECTION_TIMEOUT = 3000;
+#endif
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+#if !defined(ARDUINO_ARCH_ESP8266) && !defined(ARDUINO_ARCH_ESP32) && defined(WIFI_FIRMWARE_VERSION_REQUIRED)
+/* Compares two dot separated version strings (e.g. "1.4.8" and "1.5.0")
+ * component by component, returns a negative value if a < b, 0 if they are
+ * equal and a positive value if a > b.
+ */
+static int compareFirmwareVersion(char const * a, char const * b)
+{
+  while (*a || *b)
+  {
+    unsigned long num_a = 0, num_b = 0;
+    for (; *a >= '0' && *a <= '9'; a++) num_a = (num_a * 10) + (*a - '0');
+    for (; *b >= '0' && *b <= '9'; b++) num_b = (num_b * 10) + (*b - '0');
+    if (num_a != num_b)
+      return (num_a < num_b) ? -1 : 1;
+    /* Skip the separator */
+    if (*a) a++;
+    if (*b) b++;
+  }
+  return 0;
+}
 #endif
 
 /******************************************************************************
@@ -38,6 +65,11 @@ WiFiConnectionHandler::WiFiConnectionHandler(char const * ssid, char const * pas
 : ConnectionHandler{keep_alive, NetworkAdapter::WIFI}
 , _ssid{ssid}
 , _pass{pass}
+, _firmware_checked{false}
+#if defined(ARDUINO_ARCH_ESP8266)
+, _connection_pending{false}
+, _connection_start_ms{0}
+#endif
 {
 
 }
@@ -61,36 +93,40 @@ unsigned long WiFiConnectionHandler::getTime()
 
 NetworkConnectionState WiFiConnectionHandler::update_handleInit()
 {
-#if !defined(__AVR__)
-  Debug.print(DBG_INFO, F("WiFi.status(): %d"), WiFi.status());
-#endif
+  CH_LOG_INFO("WiFi.status(): %d", WiFi.status());
 
 #if !defined(ARDUINO_ARCH_ESP8266) && !defined(ARDUINO_ARCH_ESP32)
   if (WiFi.status() == NETWORK_HARDWARE_ERROR)
   {
-#if !defined(__AVR__)
-    Debug.print(DBG_ERROR, F("WiFi Hardware failure.\nMake sure you are using a WiFi enabled board/shield."));
-    Debug.print(DBG_ERROR, F("Then reset and retry."));
-#endif
+    CH_LOG_ERROR("WiFi Hardware failure.\nMake sure you are using a WiFi enabled board/shield.");
+    CH_LOG_ERROR("Then reset and retry.");
+    setTransitionReason(TransitionReason::HARDWARE_ERROR);
     return NetworkConnectionState::ERROR;
   }
-#if !defined(__AVR__)
-  Debug.print(DBG_INFO, F("Current WiFi Firmware: %s"), WiFi.firmwareVersion());
-#endif
 
-#if defined(WIFI_FIRMWARE_VERSION_REQUIRED)
-  if (String(WiFi.firmwareVersion()) < String(WIFI_FIRMWARE_VERSION_REQUIRED))
+  /* The firmware version can not change at runtime, hence it is only checked
+   * on the first initialization and not on every reconnection.
+   */
+  if (!_firmware_checked)
   {
-#if !defined(__AVR__)
-    Debug.print(DBG_ERROR, F("Latest WiFi Firmware: %s"), WIFI_FIRMWARE_VERSION_REQUIRED);
-    Debug.print(DBG_ERROR, F("Please update to the latest version for best performance."));
+    CH_LOG_INFO("Current WiFi Firmware: %s", WiFi.firmwareVersion());
+
+#if defined(WIFI_FIRMWARE_VERSION_REQUIRED)
+    if (compareFirmwareVersion(WiFi.firmwareVersion(), WIFI_FIRMWARE_VERSION_REQUIRED) < 0)
+    {
+      CH_LOG_ERROR("Latest WiFi Firmware: %s", WIFI_FIRMWARE_VERSION_REQUIRED);
+      CH_LOG_ERROR("Please update to the latest version for best performance.");
+      notifyFirmwareOutdated();
+    }
 #endif
-    delay(5000);
+    _firmware_checked = true;
   }
-#endif
 #else
   WiFi.mode(WIFI_STA);
 #endif /* #if !defined(ARDUINO_ARCH_ESP8266) && !defined(ARDUINO_ARCH_ESP32) */
+#if defined(ARDUINO_ARCH_ESP8266)
+  _connection_pending = false;
+#endif
   return NetworkConnectionState::CONNECTING;
 }
 
@@ -98,29 +134,39 @@ NetworkConnectionState WiFiConnectionHandler::update_handleConnecting()
 {
   if (WiFi.status() != WL_CONNECTED)
   {
-    WiFi.begin(_ssid, _pass);
 #if defined(ARDUINO_ARCH_ESP8266)
-    /* Wait connection otherwise board won't connect */
-    unsigned long start = millis();
-    while((WiFi.status() != WL_CONNECTED) && (millis() - start) < ESP_WIFI_CONNECTION_TIMEOUT) {
-      delay(100);
+    /* Start the connection once and poll for its completion on the following
+     * calls, instead of busy waiting for it and blocking the caller.
+     */
+    if (!_connection_pending)
+    {
+      WiFi.begin(_ssid, _pass);
+      _connection_pending = true;
+      _connection_start_ms = millis();
+      return NetworkConnectionState::CONNECTING;
     }
+    if ((millis() - _connection_start_ms) < ESP_WIFI_CONNECTION_TIMEOUT)
+    {
+      return NetworkConnectionState::CONNECTING;
+    }
+    _connection_pending = false;
+#else
+    WiFi.begin(_ssid, _pass);
 #endif
-
   }
 
   if (WiFi.status() != NETWORK_CONNECTED)
   {
-#if !defined(__AVR__)
-    Debug.print(DBG_ERROR, F("Connection to \"%s\" failed"), _ssid);
-    Debug.print(DBG_INFO, F("Retrying in  \"%d\" milliseconds"), CHECK_INTERVAL_TABLE[static_cast<unsigned int>(NetworkConnectionState::CONNECTING)]);
-#endif
+    CH_LOG_ERROR("Connection to \"%s\" failed", _ssid);
+    CH_LOG_INFO("Retrying in  \"%d\" milliseconds", getCheckInterval(NetworkConnectionState::CONNECTING));
+    connectionAttemptFailed();
     return NetworkConnectionState::CONNECTING;
   }
   else
   {
-#if !defined(__AVR__)
-    Debug.print(DBG_INFO, F("Connected to \"%s\""), _ssid);
+    CH_LOG_INFO("Connected to \"%s\"", _ssid);
+#if defined(ARDUINO_ARCH_ESP8266)
+    _connection_pending = false;
 #endif
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
   configTime(0, 0, "time.arduino.cc", "pool.ntp.org", "time.nist.gov");
@@ -133,17 +179,14 @@ NetworkConnectionState WiFiConnectionHandler::update_handleConnected()
 {
   if (WiFi.status() != WL_CONNECTED)
   {
-#if !defined(__AVR__)
-    Debug.print(DBG_VERBOSE, F("WiFi.status(): %d"), WiFi.status());
-    Debug.print(DBG_ERROR, F("Connection to \"%s\" lost."), _ssid);
-#endif
+    CH_LOG_VERBOSE("WiFi.status(): %d", WiFi.status());
+    CH_LOG_ERROR("Connection to \"%s\" lost.", _ssid);
     if (_keep_alive)
     {
-#if !defined(__AVR__)
-      Debug.print(DBG_INFO, F("Attempting reconnection"));
-#endif
+      CH_LOG_INFO("Attempting reconnection");
     }
   
+    setTransitionReason(TransitionReason::CONNECTION_LOST);
     return NetworkConnectionState::DISCONNECTED;
   }
   return NetworkConnectionState::CONNECTED;
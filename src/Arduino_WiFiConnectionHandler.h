@@ -54,6 +54,12 @@ class WiFiConnectionHandler : public ConnectionHandler
 
     char const * _ssid;
     char const * _pass;
+    bool _firmware_checked;
+
+#if defined(ARDUINO_ARCH_ESP8266)
+    bool _connection_pending;
+    unsigned long _connection_start_ms;
+#endif
 
     WiFiUDP _wifi_udp;
     WiFiClient _wifi_client;